@@ -0,0 +1,26 @@
+#ifndef ACTION_H
+#define ACTION_H
+
+#include "game.h"
+#include <cstdint>
+
+// Действие игрока за один тик (то же, что нажатие стрелки/WASD)
+enum Action : uint8_t {
+    ACTION_NONE,
+    ACTION_UP,
+    ACTION_DOWN,
+    ACTION_LEFT,
+    ACTION_RIGHT
+};
+
+inline void applyAction(Game& game, Action action) {
+    switch (action) {
+    case ACTION_UP: game.setPacmanDirection(0, 1); break;
+    case ACTION_DOWN: game.setPacmanDirection(0, -1); break;
+    case ACTION_LEFT: game.setPacmanDirection(-1, 0); break;
+    case ACTION_RIGHT: game.setPacmanDirection(1, 0); break;
+    case ACTION_NONE: break;
+    }
+}
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef ALLOCATIONHOOKS_H
+#define ALLOCATIONHOOKS_H
+
+// Замена глобальных operator new/delete, которая сообщает о выделениях в
+// AllocationTracker. Определяет функции, а не объявляет, поэтому
+// подключается ровно в одну единицу трансляции программы. Пока счётчик
+// выключен, выделение стоит одной проверки флага сверх malloc.
+#include "allocationTracker.h"
+#include <cstdlib>
+#include <new>
+
+inline void* trackedAllocate(std::size_t size) {
+    if (AllocationTracker::isEnabled()) AllocationTracker::onAllocate(size);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new(std::size_t size) {
+    if (void* p = trackedAllocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    if (void* p = trackedAllocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return trackedAllocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return trackedAllocate(size); }
+
+// Пара malloc/free здесь намеренная: new выше выделяет через malloc.
+// GCC этого не видит и предупреждает (-Wmismatched-new-delete).
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+// Выделения с выравниванием больше стандартного (alignas(64) и т.п.,
+// C++17). Память из них освобождается своей парой, а не free/delete выше.
+#ifdef __cpp_aligned_new
+inline void* trackedAllocateAligned(std::size_t size, std::align_val_t alignment) {
+    if (AllocationTracker::isEnabled()) AllocationTracker::onAllocate(size);
+    std::size_t align = static_cast<std::size_t>(alignment);
+#ifdef _WIN32
+    return _aligned_malloc(size ? size : 1, align);
+#else
+    // aligned_alloc требует размер, кратный выравниванию
+    std::size_t rounded = (size + align - 1) / align * align;
+    return std::aligned_alloc(align, rounded ? rounded : align);
+#endif
+}
+
+inline void trackedFreeAligned(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    if (void* p = trackedAllocateAligned(size, alignment)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    if (void* p = trackedAllocateAligned(size, alignment)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return trackedAllocateAligned(size, alignment);
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return trackedAllocateAligned(size, alignment);
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p, std::align_val_t) noexcept { trackedFreeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { trackedFreeAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { trackedFreeAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { trackedFreeAligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { trackedFreeAligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { trackedFreeAligned(p); }
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef ALLOCATIONTRACKER_H
+#define ALLOCATIONTRACKER_H
+
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// Сколько разных зон помнит один поток; остальные идут в последнюю строку
+const int ALLOCATION_SITES = 64;
+
+struct AllocationCounts {
+    uint64_t allocations;
+    uint64_t bytes;
+};
+
+// Выделения внутри одной зоны профайлера (PROFILE_ZONE)
+struct AllocationSite {
+    const char* zone;
+    uint64_t allocations;
+    uint64_t bytes;
+};
+
+// Счётчик выделений памяти. Сами выделения перехватывает allocationHooks.h
+// (замена operator new), здесь - только подсчёт. Счётчики свои у каждого
+// потока и не выделяют память сами, поэтому их можно вести из operator new.
+// Место выделения - самая вложенная зона профайлера: пока счётчик включён,
+// зоны ведут стек имён (Profiler::setZoneStack).
+class AllocationTracker {
+private:
+    // Только тривиальные поля: thread_local такого типа обнуляется без
+    // динамической инициализации
+    struct ThreadCounters {
+        AllocationCounts total;
+        AllocationSite sites[ALLOCATION_SITES];
+        int siteCount;
+    };
+
+    static ThreadCounters& counters() {
+        static thread_local ThreadCounters instance;
+        return instance;
+    }
+
+    static std::atomic<bool>& enabledFlag() {
+        static std::atomic<bool> flag(false);
+        return flag;
+    }
+
+    static AllocationSite& siteFor(ThreadCounters& c, const char* zone) {
+        for (int i = 0; i < c.siteCount; i++) {
+            if (c.sites[i].zone == zone) return c.sites[i];
+        }
+        if (c.siteCount < ALLOCATION_SITES - 1) {
+            AllocationSite& site = c.sites[c.siteCount++];
+            site.zone = zone;
+            site.allocations = 0;
+            site.bytes = 0;
+            return site;
+        }
+        // Таблица полна: всё новое - в общую последнюю строку
+        AllocationSite& other = c.sites[ALLOCATION_SITES - 1];
+        if (c.siteCount == ALLOCATION_SITES - 1) {
+            other.zone = "(other zones)";
+            other.allocations = 0;
+            other.bytes = 0;
+            c.siteCount++;
+        }
+        return other;
+    }
+
+public:
+    static bool isEnabled() { return enabledFlag().load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled) {
+        Profiler::setZoneStack(enabled);
+        enabledFlag().store(enabled, std::memory_order_relaxed);
+    }
+
+    // Вызывается из operator new, только когда счётчик включён
+    static void onAllocate(size_t bytes) {
+        ThreadCounters& c = counters();
+        c.total.allocations++;
+        c.total.bytes += bytes;
+        const char* zone = Profiler::currentZone();
+        AllocationSite& site = siteFor(c, zone ? zone : "(outside zones)");
+        site.allocations++;
+        site.bytes += bytes;
+    }
+
+    // Всего выделений этого потока с начала программы
+    static AllocationCounts threadCounts() { return counters().total; }
+
+    static void resetSites() { counters().siteCount = 0; }
+
+    // Места выделений этого потока по убыванию числа выделений
+    static void printSites(FILE* out) {
+        const ThreadCounters& c = counters();
+        AllocationSite sorted[ALLOCATION_SITES];
+        int count = c.siteCount;
+        std::copy(c.sites, c.sites + count, sorted);
+        std::sort(sorted, sorted + count, [](const AllocationSite& a, const AllocationSite& b) {
+            return a.allocations > b.allocations;
+        });
+
+        std::fprintf(out, "%-24s %12s %14s\n", "zone", "allocations", "bytes");
+        for (int i = 0; i < count; i++) {
+            std::fprintf(out, "%-24s %12llu %14llu\n", sorted[i].zone,
+                static_cast<unsigned long long>(sorted[i].allocations),
+                static_cast<unsigned long long>(sorted[i].bytes));
+        }
+    }
+};
+
+// Выделения за окно (тик, кадр): разница счётчиков потока
+class AllocationWindow {
+private:
+    AllocationCounts start;
+
+public:
+    AllocationWindow() : start(AllocationTracker::threadCounts()) {}
+
+    AllocationCounts elapsed() const {
+        AllocationCounts now = AllocationTracker::threadCounts();
+        AllocationCounts delta = { now.allocations - start.allocations, now.bytes - start.bytes };
+        return delta;
+    }
+};
+
+// Сводка по однотипным окнам: сколько их было, в скольких выделялась
+// память, сколько всего и максимум за одно окно
+struct AllocationStats {
+    uint64_t windows;
+    uint64_t windowsWithAllocations;
+    uint64_t allocations;
+    uint64_t bytes;
+    uint64_t maxAllocations;
+
+    AllocationStats() : windows(0), windowsWithAllocations(0), allocations(0), bytes(0), maxAllocations(0) {}
+
+    void add(const AllocationCounts& counts) {
+        windows++;
+        if (counts.allocations > 0) windowsWithAllocations++;
+        allocations += counts.allocations;
+        bytes += counts.bytes;
+        maxAllocations = std::max(maxAllocations, counts.allocations);
+    }
+
+    void print(FILE* out, const char* label) const {
+        std::fprintf(out, "%-8s %10llu measured, %llu allocating; %llu allocations, %llu bytes, max %llu per %s\n",
+            label, static_cast<unsigned long long>(windows),
+            static_cast<unsigned long long>(windowsWithAllocations),
+            static_cast<unsigned long long>(allocations), static_cast<unsigned long long>(bytes),
+            static_cast<unsigned long long>(maxAllocations), label);
+    }
+};
+
+#endif
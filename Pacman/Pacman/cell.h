@@ -1,23 +1,44 @@
 #ifndef CELL_H
 #define CELL_H
 
-enum CellType {
+#include <cstdint>
+
+// Тип клетки хранится одним байтом; координаты клетки - это её место в сетке
+enum CellType : uint8_t {
     EMPTY,
     WALL,
     COIN,
     POWER_POINT  
 };
 
-class Cell {
-public:
-    int x, y;
-    CellType type;
+inline bool isWalkable(CellType type) {
+    return type != WALL;
+}
 
-    Cell(int x = 0, int y = 0, CellType type = EMPTY) : x(x), y(y), type(type) {}
+// Четыре направления лабиринта. Порядок - приоритет призраков при равных
+// расстояниях; бит d маски выходов клетки отвечает за MAZE_DIRECTIONS[d].
+const int MAZE_DIRECTIONS[4][2] = {
+    {0, -1},  // Вверх (наивысший приоритет)
+    {-1, 0},  // Влево
+    {0, 1},   // Вниз
+    {1, 0}    // Вправо (наименьший приоритет)
+};
 
-    bool isWalkable() const {
-        return type == EMPTY || type == COIN || type == POWER_POINT;
+// Номер направления (dx, dy) в MAZE_DIRECTIONS или -1, если это не единичный шаг
+inline int directionIndex(int dx, int dy) {
+    if (dx == 0) {
+        if (dy == -1) return 0;
+        if (dy == 1) return 2;
     }
-};
+    else if (dy == 0) {
+        if (dx == -1) return 1;
+        if (dx == 1) return 3;
+    }
+    return -1;
+}
+
+inline int countExits(uint8_t exits) {
+    return (exits & 1) + ((exits >> 1) & 1) + ((exits >> 2) & 1) + ((exits >> 3) & 1);
+}
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,112 @@
+#ifndef COINLAYER_H
+#define COINLAYER_H
+
+#include "stateHash.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+inline int countTrailingZeros(uint64_t word) {
+#if defined(_MSC_VER)
+    unsigned long bit;
+    _BitScanForward64(&bit, word);
+    return static_cast<int>(bit);
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+// Битовый слой монет: бит на клетку и счётчик установленных битов.
+// Сбор монеты - одна проверка со сбросом, число оставшихся - O(1),
+// обход оставшихся идёт по 64 клетки за слово. Заодно ведётся хеш
+// Зобриста: XOR ключей установленных битов, обновляется за O(1).
+class CoinLayer {
+private:
+    std::vector<uint64_t> words;
+    int count;
+    uint64_t hash;
+    uint64_t salt; // разные слои дают разные ключи для одной клетки
+
+public:
+    explicit CoinLayer(uint64_t salt = 0) : count(0), hash(0), salt(salt) {}
+
+    // Ключ клетки в хеше; по нему копии слоя (например, список отрисовки)
+    // ведут свой хеш и сверяются с getHash()
+    uint64_t key(int index) const { return mix64(salt + static_cast<uint64_t>(index)); }
+
+    // Выделяет место под cellCount клеток и очищает слой
+    void resize(size_t cellCount) {
+        words.assign((cellCount + 63) / 64, 0);
+        count = 0;
+        hash = 0;
+    }
+
+    void clear() {
+        for (auto& word : words) word = 0;
+        count = 0;
+        hash = 0;
+    }
+
+    void set(int index) {
+        uint64_t mask = uint64_t(1) << (index & 63);
+        uint64_t& word = words[index >> 6];
+        if (!(word & mask)) {
+            word |= mask;
+            count++;
+            hash ^= key(index);
+        }
+    }
+
+    bool test(int index) const {
+        return (words[index >> 6] >> (index & 63)) & 1;
+    }
+
+    // Сбрасывает бит и сообщает, был ли он установлен
+    bool testAndClear(int index) {
+        uint64_t mask = uint64_t(1) << (index & 63);
+        uint64_t& word = words[index >> 6];
+        if (!(word & mask)) return false;
+        word &= ~mask;
+        count--;
+        hash ^= key(index);
+        return true;
+    }
+
+    // Копирует слова в out; false, если их больше maxWords
+    bool saveWords(uint64_t* out, size_t maxWords) const {
+        if (words.size() > maxWords) return false;
+        std::memcpy(out, words.data(), words.size() * sizeof(uint64_t));
+        return true;
+    }
+
+    // Обратное к saveWords для слоя того же размера; счётчик и хеш не
+    // пересчитываются, а берутся сохранённые
+    void loadWords(const uint64_t* in, int savedCount, uint64_t savedHash) {
+        std::memcpy(words.data(), in, words.size() * sizeof(uint64_t));
+        count = savedCount;
+        hash = savedHash;
+    }
+
+    int getCount() const { return count; }
+    uint64_t getHash() const { return hash; }
+    const uint64_t* data() const { return words.data(); }
+    size_t wordCount() const { return words.size(); }
+
+    // Вызывает fn(index) для каждого установленного бита по возрастанию
+    template <typename Fn>
+    void forEach(Fn fn) const {
+        for (size_t w = 0; w < words.size(); w++) {
+            uint64_t word = words[w];
+            while (word) {
+                fn(static_cast<int>(w * 64) + countTrailingZeros(word));
+                word &= word - 1;
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef DISTANCETABLE_H
+#define DISTANCETABLE_H
+
+#include "cell.h"
+#include "parallelRunner.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Кратчайшие расстояния по лабиринту между всеми парами проходимых клеток
+// и первый шаг кратчайшего пути. Расстояния - uint16, шаг - номер
+// направления MAZE_DIRECTIONS в байте; поиск - O(1).
+class DistanceTable {
+private:
+    std::vector<uint16_t> tileIds;   // номер проходимой клетки или NO_TILE
+    std::vector<int> tileX, tileY;   // координаты по номеру
+    std::vector<uint16_t> distances; // [to * count + from]
+    std::vector<uint8_t> nextHops;   // [to * count + from]
+    int width, height;
+    int count;
+
+    int id(int x, int y) const {
+        if (x < 0 || x >= width || y < 0 || y >= height) return NO_TILE;
+        return tileIds[y * width + x];
+    }
+
+    // BFS от клетки to заполняет её строку; родитель в дереве поиска
+    // ближе к to, поэтому направление на него - первый шаг пути
+    template <typename Map>
+    void fillRow(const Map& map, int to, std::vector<int>& queue) {
+        uint16_t* dist = &distances[static_cast<size_t>(to) * count];
+        uint8_t* hop = &nextHops[static_cast<size_t>(to) * count];
+
+        queue.clear();
+        queue.push_back(to);
+        dist[to] = 0;
+        for (size_t head = 0; head < queue.size(); head++) {
+            int current = queue[head];
+            uint8_t exits = map.exitMask(tileX[current], tileY[current]);
+            for (int d = 0; d < 4; d++) {
+                if (!((exits >> d) & 1)) continue;
+                int next = id(tileX[current] + MAZE_DIRECTIONS[d][0], tileY[current] + MAZE_DIRECTIONS[d][1]);
+                if (next == NO_TILE || dist[next] != UNREACHABLE) continue;
+                dist[next] = static_cast<uint16_t>(dist[current] + 1);
+                hop[next] = static_cast<uint8_t>((d + 2) & 3); // обратно к current
+                queue.push_back(next);
+            }
+        }
+    }
+
+public:
+    enum : uint16_t { NO_TILE = 0xFFFF, UNREACHABLE = 0xFFFF };
+    enum : uint8_t { NO_HOP = 0xFF };
+
+    DistanceTable() : width(0), height(0), count(0) {}
+
+    // Map должна давать getWidth/getHeight, canMove и exitMask (см. GameMap).
+    // Строки считаются независимо на всех потоках runner. Возвращает false,
+    // если проходимых клеток больше, чем помещается в uint16.
+    template <typename Map>
+    bool build(const Map& map, ParallelRunner& runner) {
+        width = map.getWidth();
+        height = map.getHeight();
+        tileIds.assign(static_cast<size_t>(width) * height, NO_TILE);
+        tileX.clear();
+        tileY.clear();
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                if (!map.canMove(static_cast<float>(x), static_cast<float>(y))) continue;
+                if (tileX.size() >= NO_TILE) {
+                    count = 0;
+                    return false;
+                }
+                tileIds[y * width + x] = static_cast<uint16_t>(tileX.size());
+                tileX.push_back(x);
+                tileY.push_back(y);
+            }
+        }
+
+        count = static_cast<int>(tileX.size());
+        distances.assign(static_cast<size_t>(count) * count, UNREACHABLE);
+        nextHops.assign(static_cast<size_t>(count) * count, NO_HOP);
+
+        // Очередь BFS своя у каждой строки, чтобы потоки не делили память
+        runner.run(static_cast<size_t>(count), [this, &map](size_t to) {
+            std::vector<int> queue;
+            queue.reserve(count);
+            fillRow(map, static_cast<int>(to), queue);
+        });
+        return true;
+    }
+
+    // Длина кратчайшего пути в шагах или -1 (стена, вне карты, недостижимо)
+    int distance(int fromX, int fromY, int toX, int toY) const {
+        int from = id(fromX, fromY);
+        int to = id(toX, toY);
+        if (from == NO_TILE || to == NO_TILE) return -1;
+        uint16_t d = distances[static_cast<size_t>(to) * count + from];
+        return d == UNREACHABLE ? -1 : d;
+    }
+
+    // Номер направления MAZE_DIRECTIONS первого шага к цели или -1
+    // (нет пути или клетки совпадают)
+    int nextHop(int fromX, int fromY, int toX, int toY) const {
+        int from = id(fromX, fromY);
+        int to = id(toX, toY);
+        if (from == NO_TILE || to == NO_TILE) return -1;
+        uint8_t hop = nextHops[static_cast<size_t>(to) * count + from];
+        return hop == NO_HOP ? -1 : hop;
+    }
+
+    int getTileCount() const { return count; }
+
+    size_t memoryUsage() const {
+        return sizeof(DistanceTable) + tileIds.capacity() * sizeof(uint16_t) +
+            (tileX.capacity() + tileY.capacity()) * sizeof(int) +
+            distances.capacity() * sizeof(uint16_t) + nextHops.capacity();
+    }
+};
+
+#endif
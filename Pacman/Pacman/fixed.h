@@ -0,0 +1,79 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <cstdint>
+
+// Позиции и скорости в целых долях клетки: клетка = FIXED_ONE единиц,
+// центр клетки (x, y) - точка (x * FIXED_ONE, y * FIXED_ONE). Все скорости
+// игры (0.1, 0.08, 0.075 ... клетки за тик) в этих единицах целые, поэтому
+// движение точное и одинаковое на любом компиляторе и процессоре.
+const int FIXED_ONE = 1000;
+const int FIXED_HALF = FIXED_ONE / 2;
+
+inline int fixedFromTile(int tile) {
+    return tile * FIXED_ONE;
+}
+
+// Деление с округлением вниз (для отрицательных тоже)
+inline int floorDiv(int value, int divisor) {
+    int q = value / divisor;
+    return (value % divisor != 0 && (value < 0) != (divisor < 0)) ? q - 1 : q;
+}
+
+// Ближайшая клетка; половина округляется от нуля, как std::round
+inline int fixedRoundToTile(int value) {
+    return value >= 0 ? (value + FIXED_HALF) / FIXED_ONE : -((-value + FIXED_HALF) / FIXED_ONE);
+}
+
+// Отбрасывание дробной части к нулю, как static_cast<int>(float)
+inline int fixedTruncToTile(int value) {
+    return value / FIXED_ONE;
+}
+
+// Ровно в центре клетки
+inline bool fixedIsCentered(int value) {
+    return value % FIXED_ONE == 0;
+}
+
+// Следующий центр клетки по направлению dir (+1/-1), не считая текущего
+inline int fixedNextCenter(int value, int dir) {
+    return dir > 0 ? (floorDiv(value, FIXED_ONE) + 1) * FIXED_ONE
+                   : (floorDiv(value - 1, FIXED_ONE)) * FIXED_ONE;
+}
+
+// Сколько шагов по speed в направлении dir (+1/-1) можно сделать из value,
+// не сменив клетку округления fixedRoundToTile
+inline int fixedStepsInTile(int value, int dir, int speed) {
+    int tile = fixedRoundToTile(value);
+    int low, high; // значения, которые округляются в ту же клетку
+    if (tile > 0) {
+        low = tile * FIXED_ONE - FIXED_HALF;
+        high = tile * FIXED_ONE + FIXED_HALF - 1;
+    }
+    else if (tile < 0) {
+        low = tile * FIXED_ONE - FIXED_HALF + 1;
+        high = tile * FIXED_ONE + FIXED_HALF;
+    }
+    else {
+        low = -FIXED_HALF + 1;
+        high = FIXED_HALF - 1;
+    }
+    return dir > 0 ? (high - value) / speed : (value - low) / speed;
+}
+
+// "Событий не предвидится" для ticksToNextEvent() у Pacman и Ghost
+const int NO_EVENT = 0x7FFFFFFF;
+
+// Только для отрисовки и отладки
+inline float fixedToFloat(int value) {
+    return static_cast<float>(value) / FIXED_ONE;
+}
+
+// Квадрат расстояния между точками; 64 бита, чтобы не переполниться
+inline int64_t fixedDistanceSquared(int ax, int ay, int bx, int by) {
+    int64_t dx = static_cast<int64_t>(ax) - bx;
+    int64_t dy = static_cast<int64_t>(ay) - by;
+    return dx * dx + dy * dy;
+}
+
+#endif
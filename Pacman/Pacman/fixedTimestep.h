@@ -0,0 +1,64 @@
+#ifndef FIXEDTIMESTEP_H
+#define FIXEDTIMESTEP_H
+
+// Накопитель времени для симуляции с постоянным шагом. Отрисовка идёт с
+// любой частотой: каждый кадр сообщает прошедшее время, advance() отвечает,
+// сколько тиков симуляции выполнить, а alpha() - насколько кадр ушёл от
+// последнего тика к следующему (для интерполяции позиций).
+class FixedTimestep {
+private:
+    double tickSeconds;
+    double accumulator;
+    int maxTicksPerFrame;
+    long long droppedTicks;
+
+public:
+    // maxTicksPerFrame ограничивает догоняние после долгого кадра: лишнее
+    // время выбрасывается, иначе медленный кадр тянет за собой следующий
+    explicit FixedTimestep(int ticksPerSecond = 60, int maxTicksPerFrame = 8)
+        : tickSeconds(1.0 / ticksPerSecond), accumulator(0.0),
+        maxTicksPerFrame(maxTicksPerFrame), droppedTicks(0) {
+    }
+
+    void setTickRate(int ticksPerSecond) {
+        if (ticksPerSecond > 0) {
+            tickSeconds = 1.0 / ticksPerSecond;
+        }
+    }
+
+    int getTickRate() const { return static_cast<int>(1.0 / tickSeconds + 0.5); }
+    double getTickSeconds() const { return tickSeconds; }
+
+    // Добавляет прошедшее время и возвращает число тиков к выполнению
+    int advance(double elapsedSeconds) {
+        if (elapsedSeconds > 0.0) {
+            accumulator += elapsedSeconds;
+        }
+
+        int ticks = static_cast<int>(accumulator / tickSeconds);
+        if (ticks > maxTicksPerFrame) {
+            droppedTicks += ticks - maxTicksPerFrame;
+            ticks = maxTicksPerFrame;
+            accumulator = 0.0;
+        }
+        else {
+            accumulator -= ticks * tickSeconds;
+        }
+        return ticks;
+    }
+
+    // Доля тика, прошедшая после последнего выполненного тика, в [0, 1)
+    float alpha() const {
+        float a = static_cast<float>(accumulator / tickSeconds);
+        return a < 1.0f ? a : 1.0f;
+    }
+
+    // Сбрасывает накопленное время (например, после паузы)
+    void reset() {
+        accumulator = 0.0;
+    }
+
+    long long getDroppedTicks() const { return droppedTicks; }
+};
+
+#endif
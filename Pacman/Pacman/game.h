@@ -4,17 +4,40 @@
 #include "pacman.h"
 #include "ghost.h"
 #include "gameMap.h"
+#include "random.h"
+#include "fixed.h"
+#include "gameState.h"
+#include "stateHash.h"
+#include "gameEvents.h"
+#include "ghostPositions.h"
+#include "profiler.h"
+#include <cstdint>
 #include <vector>
 #include <ctime>
 #include <algorithm>
 #include <cmath>
-#include <iostream>
+#include <cstdlib>
+
+// Скорости в единицах FIXED_ONE за тик
+const int PACMAN_BASE_SPEED = FIXED_ONE / 10;        // 0.1 клетки
+const int PACMAN_LEVEL_SPEEDUP = FIXED_ONE / 100;    // +0.01 за уровень
+const int GHOST_SPEEDS[4] = {
+    FIXED_ONE * 80 / 1000,  // Blinky
+    FIXED_ONE * 75 / 1000,  // Pinky
+    FIXED_ONE * 70 / 1000,  // Inky
+    FIXED_ONE * 65 / 1000   // Clyde
+};
+const int COLLISION_RADIUS = FIXED_ONE * 7 / 10;
+static_assert(COLLISION_RADIUS <= MAX_CONTACT_RADIUS, "collision radius is too large for GhostPositions");
+const int CLASSIC_GHOST_COUNT = 4;
 
 class Game {
 private:
     Pacman pacman;
-    std::vector<Ghost> ghosts;
+    GhostTable ghosts;
+    int ghostsPerLevel;
     GameMap map;
+    Random rng; // случайность только отсюда: одинаковый seed - одинаковая партия
     int level;
     int score;
     int highScore;
@@ -25,11 +48,399 @@ private:
     int powerModeTimer;
     bool ghostsVulnerable;
     int flashTimer;
+    uint32_t tick; // число вызовов update()
+    StateHashListener* hashListener;
+    uint32_t hashInterval;
+    uint32_t nextHashTick; // ближайший тик, кратный hashInterval, после текущего
+    GameEventBuffer events;
+    std::vector<uint32_t> ghostClocks; // рабочие массивы fastForwardChunk
+    std::vector<uint64_t> eventKeys;
+    std::vector<uint32_t> runStarts;
+    std::vector<GhostState> runStates;
+
+    // Событие в клетке Пакмана на текущем тике
+    void emit(GameEventType type, int value, int ghost = -1) {
+        GameEvent event;
+        event.tick = tick;
+        event.type = type;
+        event.ghost = static_cast<int16_t>(ghost);
+        event.x = static_cast<int16_t>(fixedRoundToTile(pacman.getFixedX()));
+        event.y = static_cast<int16_t>(fixedRoundToTile(pacman.getFixedY()));
+        event.value = value;
+        events.push(event);
+    }
+
+    // После прыжка tick (снимок, смена listener) - без деления на каждом тике
+    void scheduleHash() {
+        nextHashTick = (tick / hashInterval + 1) * hashInterval;
+    }
+
+    // Обновляем таймер режима силы и мигания
+    void updatePowerTimer() {
+        if (!powerMode) return;
+        powerModeTimer--;
+        flashTimer++;
+
+        // Мигание каждые 10 кадров
+        if (flashTimer >= 10) {
+            flashTimer = 0;
+        }
+
+        if (powerModeTimer <= 0) {
+            powerMode = false;
+            ghostsVulnerable = false;
+            emit(EVENT_POWER_MODE_ENDED, 0);
+        }
+    }
+
+    static const char* ghostZoneName(size_t index) {
+        static const char* const names[] = { "ghost 0 (Blinky)", "ghost 1 (Pinky)", "ghost 2 (Inky)", "ghost 3 (Clyde)" };
+        return index < 4 ? names[index] : "ghost";
+    }
+
+    // Один тик игровой логики
+    void updateLogic() {
+        if (gameOver || levelComplete || !gameStarted) return;
+
+        updatePowerTimer();
+        {
+            PROFILE_ZONE("pacman update");
+            pacman.update(map);
+        }
+        {
+            PROFILE_ZONE("pellet check");
+            checkPelletCollection();
+        }
+
+        for (size_t i = 0; i < ghosts.size(); i++) {
+            PROFILE_ZONE(ghostZoneName(i));
+            ghosts.update(i, map, pacman, rng);
+        }
+
+        {
+            PROFILE_ZONE("collisions");
+            checkCollisions();
+        }
+        {
+            PROFILE_ZONE("level check");
+            checkLevelCompletion();
+        }
+    }
+
+    // --- Перемотка по событиям (fastForward) ---
+    // Каждый участник (таймер силы, Пакман, призраки) живёт по своему
+    // локальному тику и между своими событиями сдвигается формулой
+    // (coast). События обрабатываются настоящим кодом update() в порядке
+    // (тик, порядок внутри update()), поэтому генератор и все зависимости
+    // "призрак смотрит на Пакмана этого тика" совпадают с потиковым
+    // движком. Столкновения проверяются в точках синхронизации: до них
+    // участники не успевают сблизиться даже при встречном движении.
+    // Пока Пакман стоит, призрак проходит клетки прогоном без касаний
+    // (GhostTable::runBetweenCenters) и может уйти за точку синхронизации;
+    // если ей нужны все призраки на её тике, она откатывает прогоны.
+
+    static const uint64_t NEVER = UINT64_MAX;
+
+    static uint64_t eventAt(uint32_t at, int ticks) {
+        return ticks == NO_EVENT ? NEVER : at + static_cast<uint64_t>(ticks);
+    }
+
+    uint64_t nextPowerEvent(uint32_t at) const {
+        return powerMode ? at + static_cast<uint64_t>(std::max(1, powerModeTimer)) : NEVER;
+    }
+
+    uint64_t nextPacmanEvent(uint32_t at) const {
+        int tileX = fixedTruncToTile(pacman.getFixedX() + FIXED_HALF);
+        int tileY = fixedTruncToTile(pacman.getFixedY() + FIXED_HALF);
+        if (map.hasCoin(tileX, tileY) || map.hasPowerPoint(tileX, tileY)) return at + 1;
+        return eventAt(at, pacman.ticksToNextEvent());
+    }
+
+    void coastPowerTimer(uint32_t& at, uint32_t to) {
+        if (powerMode) {
+            powerModeTimer -= static_cast<int>(to - at);
+            flashTimer = static_cast<int>((flashTimer + (to - at)) % 10);
+        }
+        at = to;
+    }
+
+    // Тиков без возможного касания: за тик расстояние сокращается не
+    // больше чем на сумму скоростей (скачки при упоре в стену ловит
+    // fastForwardChunk). Стоящий Пакман без поворота в очереди не
+    // тронется до нового ввода, то есть до конца перемотки. Если он при
+    // этом в центре клетки, а призрак на линиях центров, касание возможно
+    // только на общей линии (радиус меньше клетки), и расстояние берётся
+    // по сумме модулей разностей: оно больше и считается без корня.
+    // Призрак, ушедший прогоном вперёд (его тик в ghostClocks позже at),
+    // до своего тика касаний не имеет, и отсчёт идёт от его тика.
+    uint32_t contactFreeTicks(uint32_t at) const {
+        static_assert(COLLISION_RADIUS < FIXED_ONE, "contact must stay on one grid line");
+        int64_t best = INT32_MAX;
+        int pacmanX = pacman.getFixedX(), pacmanY = pacman.getFixedY();
+        int pacmanSpeed = pacman.ticksToNextEvent() == NO_EVENT ? 0 : pacman.getFixedSpeed();
+        bool pacmanCentered = pacmanSpeed == 0 && fixedIsCentered(pacmanX) && fixedIsCentered(pacmanY);
+        for (size_t i = 0; i < ghosts.size(); i++) {
+            int64_t distance;
+            if (pacmanCentered && ghosts.staysOnGridLines(i)) {
+                distance = std::abs(static_cast<int64_t>(ghosts.getFixedX(i)) - pacmanX) +
+                    std::abs(static_cast<int64_t>(ghosts.getFixedY(i)) - pacmanY);
+            }
+            else {
+                int64_t squared = fixedDistanceSquared(pacmanX, pacmanY, ghosts.getFixedX(i), ghosts.getFixedY(i));
+                distance = static_cast<int64_t>(std::sqrt(static_cast<double>(squared)));
+                while (distance * distance > squared) distance--;
+                while ((distance + 1) * (distance + 1) <= squared) distance++;
+            }
+            int64_t gap = distance - COLLISION_RADIUS;
+            if (gap < 0) return 0;
+            int closing = pacmanSpeed + ghosts.getFixedSpeed(i);
+            if (closing > 0) best = std::min(best, static_cast<int64_t>(ghostClocks[i] - at) + gap / closing);
+        }
+        return static_cast<uint32_t>(best);
+    }
+
+    // Сдвиг за тик больше скорости - выравнивание по клетке при упоре
+    static bool jumped(int oldX, int oldY, int newX, int newY, int speed) {
+        return std::abs(newX - oldX) + std::abs(newY - oldY) > speed;
+    }
+
+    // Очередь событий - ключи (тик << 32) | участник, поэтому ближайшее
+    // событие - просто минимум ключей без ветвлений, а при равном тике
+    // меньший номер участника совпадает с порядком в updateLogic():
+    // таймер силы, Пакман, призраки по порядку, затем точка синхронизации
+    // (её номер - SLOT_GHOSTS + число призраков)
+    enum {
+        SLOT_POWER = 0,
+        SLOT_PACMAN = 1,
+        SLOT_GHOSTS = 2
+    };
+
+    // События позже UINT32_MAX тиков перемотка не ждёт
+    static uint64_t eventKey(uint64_t when, int slot) {
+        return when > UINT32_MAX ? NEVER : (when << 32) | static_cast<uint64_t>(slot);
+    }
+
+    // До n тиков идущей игры; возвращает, сколько прошло (меньше n, если
+    // игра кончилась или уровень пройден)
+    uint32_t fastForwardChunk(uint32_t n) {
+        const uint32_t startTick = tick;
+        const int ghostCount = static_cast<int>(ghosts.size());
+        const int syncSlot = SLOT_GHOSTS + ghostCount;
+        const int slotCount = syncSlot + 1;
+        uint32_t powerAt = 0, pacmanAt = 0;
+        // Локальные тики призраков и ключи - в членах, чтобы не выделять память
+        ghostClocks.resize(ghostCount);
+        eventKeys.resize(slotCount);
+        runStarts.resize(ghostCount);
+        runStates.resize(ghostCount);
+        uint32_t* ghostAt = ghostClocks.data();
+        uint64_t* keys = eventKeys.data();
+
+        auto scheduleSync = [&](uint32_t at) {
+            uint64_t next = at + 1 + static_cast<uint64_t>(contactFreeTicks(at));
+            if (hashListener) next = std::min(next, static_cast<uint64_t>(nextHashTick - startTick));
+            keys[syncSlot] = eventKey(next, syncSlot);
+        };
+        auto syncAt = [&](uint32_t at) {
+            keys[syncSlot] = std::min(keys[syncSlot], eventKey(at, syncSlot));
+        };
+        auto scheduleGhost = [&](int i, uint32_t at) {
+            keys[SLOT_GHOSTS + i] = eventKey(eventAt(at, ghosts.ticksToNextEvent(i, map)), SLOT_GHOSTS + i);
+        };
+        auto scheduleAll = [&](uint32_t at) {
+            keys[SLOT_POWER] = eventKey(nextPowerEvent(at), SLOT_POWER);
+            keys[SLOT_PACMAN] = eventKey(nextPacmanEvent(at), SLOT_PACMAN);
+            for (int i = 0; i < ghostCount; i++) {
+                ghostAt[i] = at;
+                scheduleGhost(i, at);
+            }
+            scheduleSync(at);
+        };
+        auto coastPacman = [&](uint32_t to) {
+            pacman.coast(static_cast<int>(to - pacmanAt));
+            pacmanAt = to;
+        };
+        auto coastGhost = [&](int i, uint32_t to) {
+            ghosts.coast(i, static_cast<int>(to - ghostAt[i]));
+            ghostAt[i] = to;
+        };
+        // Призраки, ушедшие прогоном дальше to, не трогаются
+        auto coastAll = [&](uint32_t to) {
+            coastPowerTimer(powerAt, to);
+            coastPacman(to);
+            for (int i = 0; i < ghostCount; i++) {
+                if (ghostAt[i] < to) coastGhost(i, to);
+            }
+        };
+        // Ушедших дальше to - обратно на to: с начала прогона заново, но
+        // только до to. Прогон зависит лишь от призрака и неподвижного
+        // Пакмана, поэтому повторяется тик в тик.
+        auto rewindAll = [&](uint32_t to) {
+            for (int i = 0; i < ghostCount; i++) {
+                if (ghostAt[i] <= to) continue;
+                ghosts.loadState(i, runStates[i]);
+                int span = ghosts.runBetweenCenters(i, static_cast<int>(to + 1 - runStarts[i]), map, pacman,
+                    COLLISION_RADIUS);
+                ghostAt[i] = to;
+                keys[SLOT_GHOSTS + i] = eventKey(runStarts[i] + static_cast<uint64_t>(span), SLOT_GHOSTS + i);
+            }
+        };
+
+        scheduleAll(0);
+        for (;;) {
+            uint64_t key = keys[0];
+            for (int i = 1; i < slotCount; i++) key = std::min(key, keys[i]);
+            if (key == NEVER || (key >> 32) > n) break;
+            uint32_t at = static_cast<uint32_t>(key >> 32);
+            int slot = static_cast<int>(key & 0xFFFFFFFF);
+            tick = startTick + at; // для событий GameEventBuffer
+
+            if (slot == SLOT_POWER) {
+                coastPowerTimer(powerAt, at - 1);
+                updatePowerTimer();
+                powerAt = at;
+                keys[SLOT_POWER] = eventKey(nextPowerEvent(at), SLOT_POWER);
+            }
+            else if (slot == SLOT_PACMAN) {
+                coastPowerTimer(powerAt, at);
+                coastPacman(at - 1);
+                int oldX = pacman.getFixedX(), oldY = pacman.getFixedY();
+                pacman.update(map);
+                pacmanAt = at;
+                if (jumped(oldX, oldY, pacman.getFixedX(), pacman.getFixedY(), pacman.getFixedSpeed())) syncAt(at);
+
+                // Энергетик пугает призраков до их хода в этом тике
+                int tileX = fixedTruncToTile(pacman.getFixedX() + FIXED_HALF);
+                int tileY = fixedTruncToTile(pacman.getFixedY() + FIXED_HALF);
+                bool power = map.hasPowerPoint(tileX, tileY);
+                if (power) {
+                    for (int i = 0; i < ghostCount; i++) coastGhost(i, at - 1);
+                }
+                checkPelletCollection();
+                if (power) {
+                    keys[SLOT_POWER] = eventKey(nextPowerEvent(at), SLOT_POWER);
+                    for (int i = 0; i < ghostCount; i++) scheduleGhost(i, at - 1);
+                }
+                if (map.countRemainingCoins() == 0) syncAt(at);
+                keys[SLOT_PACMAN] = eventKey(nextPacmanEvent(at), SLOT_PACMAN);
+            }
+            else if (slot < syncSlot) {
+                int i = slot - SLOT_GHOSTS;
+                coastGhost(i, at - 1);
+
+                // Пока Пакман стоит, переходы призрака между центрами ни от
+                // кого не зависят: выполняем их подряд, не возвращаясь в
+                // очередь, до ближайшего события Пакмана или хеша. Точки
+                // синхронизации прогон проходит насквозь: касаний на нём
+                // нет, а если синхронизации нужны все призраки на её тике,
+                // она возвращает их туда (rewindAll).
+                int span = 0, window = 0;
+                if (pacman.getDirectionX() == 0 && pacman.getDirectionY() == 0) {
+                    uint64_t limit = std::min(keys[SLOT_PACMAN] >> 32, static_cast<uint64_t>(n) + 1);
+                    if (hashListener) limit = std::min(limit, static_cast<uint64_t>(nextHashTick - startTick));
+                    window = static_cast<int>(limit - at);
+                    ghosts.saveState(i, runStates[i]);
+                    span = ghosts.runBetweenCenters(i, window, map, pacman, COLLISION_RADIUS);
+                }
+                if (span > 0) {
+                    runStarts[i] = at;
+                    ghostAt[i] = at - 1 + std::min(span, window);
+                    keys[slot] = eventKey(at + static_cast<uint64_t>(span), slot);
+                    continue;
+                }
+
+                coastPacman(at);
+                int oldX = ghosts.getFixedX(i), oldY = ghosts.getFixedY(i);
+                ghosts.update(i, map, pacman, rng);
+                ghostAt[i] = at;
+                if (jumped(oldX, oldY, ghosts.getFixedX(i), ghosts.getFixedY(i), ghosts.getFixedSpeed(i))) syncAt(at);
+                scheduleGhost(i, at);
+            }
+            else {
+                coastAll(at);
+                // Касание и конец уровня меняют всех призраков. Ушедшие
+                // вперёд Пакмана не касаются, так что без касания в
+                // массиве позиций его нет и на тике at.
+                bool collided = false;
+                if (map.countRemainingCoins() == 0 ||
+                    ghosts.getPositions().firstContact(pacman.getFixedX(), pacman.getFixedY(), COLLISION_RADIUS) >= 0) {
+                    rewindAll(at);
+                    collided = checkCollisions();
+                }
+                checkLevelCompletion();
+                if (hashListener && tick == nextHashTick) {
+                    nextHashTick += hashInterval;
+                    hashListener->onStateHash(tick, stateHash());
+                }
+                if (gameOver || levelComplete) return at;
+                // Съеденный призрак или смерть переставляют участников
+                if (collided) scheduleAll(at);
+                else scheduleSync(at);
+            }
+        }
+
+        coastAll(n);
+        tick = startTick + n;
+        return n;
+    }
+
+    // Снимок целиком; extraGhosts - место для призраков сверх MAX_GHOSTS
+    bool saveState(GameState& out, GhostState* extraGhosts) const {
+        out.rng = rng.getState();
+        out.level = level;
+        out.score = score;
+        out.highScore = highScore;
+        out.powerModeTimer = powerModeTimer;
+        out.flashTimer = flashTimer;
+        out.gameOver = gameOver;
+        out.levelComplete = levelComplete;
+        out.gameStarted = gameStarted;
+        out.powerMode = powerMode;
+        out.ghostsVulnerable = ghostsVulnerable;
+        out.tick = tick;
+        out.ghostCount = static_cast<int32_t>(ghosts.size());
+        pacman.saveState(out.pacman);
+        for (size_t i = 0; i < ghosts.size(); i++) {
+            ghosts.saveState(i, i < static_cast<size_t>(MAX_GHOSTS) ? out.ghosts[i] : extraGhosts[i - MAX_GHOSTS]);
+        }
+        return map.saveState(out.map);
+    }
+
+    bool loadState(const GameState& in, const GhostState* extraGhosts) {
+        if (!map.loadState(in.map)) return false;
+
+        rng.setState(in.rng);
+        level = in.level;
+        score = in.score;
+        highScore = in.highScore;
+        powerModeTimer = in.powerModeTimer;
+        flashTimer = in.flashTimer;
+        gameOver = in.gameOver != 0;
+        levelComplete = in.levelComplete != 0;
+        gameStarted = in.gameStarted != 0;
+        powerMode = in.powerMode != 0;
+        ghostsVulnerable = in.ghostsVulnerable != 0;
+        tick = in.tick;
+        scheduleHash();
+        events.clear(); // события другой ветки партии
+        pacman.loadState(in.pacman);
+        size_t count = static_cast<size_t>(in.ghostCount);
+        if (ghosts.size() != count) ghosts.assign(count);
+        for (size_t i = 0; i < count; i++) {
+            ghosts.loadState(i, i < static_cast<size_t>(MAX_GHOSTS) ? in.ghosts[i] : extraGhosts[i - MAX_GHOSTS]);
+        }
+        return true;
+    }
 
 public:
-    Game(int width, int height) :
+    // ghostCount - призраков на уровне; сверх четырёх классических они
+    // повторяют их цвета, скорости и места появления по кругу. Снимок с
+    // числом призраков больше MAX_GHOSTS - snapshot(out, extraGhosts).
+    Game(int width, int height, uint64_t seed = 1, int ghostCount = CLASSIC_GHOST_COUNT) :
+        pacman(width * FIXED_HALF, FIXED_ONE),
+        ghostsPerLevel(ghostCount > 0 ? ghostCount : 0),
         map(width, height),
-        pacman(width / 2.0f, 1.0f),
+        rng(seed),
         level(1),
         score(0),
         highScore(0),
@@ -39,27 +450,27 @@ public:
         powerMode(false),
         powerModeTimer(0),
         ghostsVulnerable(false),
-        flashTimer(0)
+        flashTimer(0),
+        tick(0),
+        hashListener(nullptr),
+        hashInterval(1),
+        nextHashTick(1)
     {
         initializeGhosts();
     }
 
     void initializeGhosts() {
-        ghosts.clear();
-        int mapWidth = map.getWidth();
-        int mapHeight = map.getHeight();
-
-      
-        ghosts.push_back(Ghost(9, 22, RED));   
-        ghosts.push_back(Ghost(8, 21, PINK));   
-        ghosts.push_back(Ghost(9, 21, CYAN));  
-        ghosts.push_back(Ghost(10, 21, ORANGE)); 
+        static const int spawns[CLASSIC_GHOST_COUNT][2] = { {9, 22}, {8, 21}, {9, 21}, {10, 21} };
+        static const GhostColor colors[CLASSIC_GHOST_COUNT] = { RED, PINK, CYAN, ORANGE };
 
-        // Даем им начальные направления
-        ghosts[0].setSpeed(0.08f); // Blinky
-        ghosts[1].setSpeed(0.075f); // Pinky  
-        ghosts[2].setSpeed(0.07f); // Inky
-        ghosts[3].setSpeed(0.065f); // Clyde
+        // clear() сохраняет ёмкость: новые уровни и рестарты не выделяют память
+        ghosts.clear();
+        ghosts.reserve(ghostsPerLevel);
+        for (int i = 0; i < ghostsPerLevel; i++) {
+            int kind = i % CLASSIC_GHOST_COUNT;
+            ghosts.add(spawns[kind][0], spawns[kind][1], colors[kind]);
+            ghosts.setSpeed(i, GHOST_SPEEDS[kind]);
+        }
     }
 
     void startGame() {
@@ -68,97 +479,87 @@ public:
         }
     }
 
+    // Тик считается и тогда, когда игра стоит (до старта, после проигрыша):
+    // номер тика совпадает с номером тика записи
     void update() {
-        if (gameOver || levelComplete || !gameStarted) return;
-
-        // Обновляем таймер режима силы и мигания
-        if (powerMode) {
-            powerModeTimer--;
-            flashTimer++;
+        PROFILE_ZONE("Game::update");
+        tick++;
+        updateLogic();
+        if (hashListener && tick == nextHashTick) {
+            nextHashTick += hashInterval;
+            hashListener->onStateHash(tick, stateHash());
+        }
+    }
 
-            // Мигание каждые 10 кадров
-            if (flashTimer >= 10) {
-                flashTimer = 0;
+    // То же, что ticks вызовов update() без ввода между ними, но прыжками
+    // от события к событию: тики, где все только едут по прямой и считают
+    // таймеры, не выполняются по одному. Результат совпадает тик в тик,
+    // включая поток хешей для listener. Число призраков любое, в том
+    // числе больше MAX_GHOSTS: рабочие массивы перемотки - векторы.
+    void fastForward(uint32_t ticks) {
+        PROFILE_ZONE("Game::fastForward");
+        while (ticks > 0) {
+            bool idle = gameOver || levelComplete || !gameStarted;
+            if (idle && !hashListener) {
+                tick += ticks;
+                return;
             }
-
-            if (powerModeTimer <= 0) {
-                powerMode = false;
-                ghostsVulnerable = false;
-                std::cout << "POWER MODE ENDED!" << std::endl;
+            if (idle || map.countRemainingCoins() == 0) {
+                update();
+                ticks--;
+                continue;
             }
+            ticks -= fastForwardChunk(ticks);
         }
-
-        pacman.update(map);
-        checkCoinCollection();
-        checkPowerPointCollection();
-
-        for (auto& ghost : ghosts) {
-            ghost.update(map, pacman);
-        }
-
-        checkCollisions();
-        checkLevelCompletion();
     }
 
-    void checkCollisions() {
-        float pacmanX = pacman.getX();
-        float pacmanY = pacman.getY();
-
-        for (auto& ghost : ghosts) {
-            float ghostX = ghost.getX();
-            float ghostY = ghost.getY();
-
-            // Проверяем столкновение по области
-            float distance = std::sqrt(std::pow(pacmanX - ghostX, 2) + std::pow(pacmanY - ghostY, 2));
-            float collisionRadius = 0.7f;
+    // true - было столкновение (съеден призрак или Пакман). Касание ищется
+    // по массивам позиций таблицы призраков (SIMD, квадраты расстояний);
+    // срабатывает только первый по порядку призрак, как раньше.
+    bool checkCollisions() {
+        int i = ghosts.getPositions().firstContact(pacman.getFixedX(), pacman.getFixedY(), COLLISION_RADIUS);
+        if (i < 0) return false;
+
+        if (ghostsVulnerable) {
+            // В режиме силы Пакман ест призраков
+            emit(EVENT_GHOST_EATEN, 200, i);
+            ghosts.respawn(i);
+            score += 200;
+            highScore = std::max(score, highScore);
+        }
+        else {
+            // Обычный режим - Пакман умирает
+            pacman.die();
+            emit(EVENT_PACMAN_DIED, pacman.getLives());
+            if (!pacman.isAlive()) {
+                gameOver = true;
+                emit(EVENT_GAME_OVER, 0);
+            }
+            pacman.resetPosition(map.getWidth() * FIXED_HALF, FIXED_ONE);
 
-            if (distance < collisionRadius) {
-                if (ghostsVulnerable) {
-                    // В режиме силы Пакман ест призраков
-                    std::cout << "Pacman ate ghost! Score +200" << std::endl;
-                    ghost.respawn(map.getWidth(), map.getHeight());
-                    score += 200;
-                    highScore = std::max(score, highScore);
-                }
-                else {
-                    // Обычный режим - Пакман умирает
-                    std::cout << "Pacman died!" << std::endl;
-                    pacman.die();
-                    if (!pacman.isAlive()) {
-                        gameOver = true;
-                        std::cout << "GAME OVER!" << std::endl;
-                    }
-                    pacman.resetPosition(map.getWidth() / 2.0f, 1.0f);
-
-                    // Сбрасываем всех призраков
-                    for (auto& g : ghosts) {
-                        g.resetPosition(g.getX(), g.getY());
-                    }
-                    powerMode = false;
-                    ghostsVulnerable = false;
-                }
-                break;
+            // Сбрасываем всех призраков
+            for (size_t g = 0; g < ghosts.size(); g++) {
+                ghosts.resetPosition(g, ghosts.getFixedX(g), ghosts.getFixedY(g));
             }
+            powerMode = false;
+            ghostsVulnerable = false;
         }
+        return true;
     }
 
-    void checkCoinCollection() {
-        int pacmanX = static_cast<int>(pacman.getX() + 0.5f);
-        int pacmanY = static_cast<int>(pacman.getY() + 0.5f);
+    // Монета и энергетик за один поиск: клетка проверяется и очищается сразу
+    void checkPelletCollection() {
+        int pacmanX = fixedTruncToTile(pacman.getFixedX() + FIXED_HALF);
+        int pacmanY = fixedTruncToTile(pacman.getFixedY() + FIXED_HALF);
 
-        if (map.hasCoin(pacmanX, pacmanY)) {
-            map.collectCoin(pacmanX, pacmanY);
+        CellType eaten = map.collectAt(pacmanX, pacmanY);
+        if (eaten == COIN) {
+            emit(EVENT_COIN_EATEN, 10);
             score += 10;
             highScore = std::max(score, highScore);
         }
-    }
-
-    void checkPowerPointCollection() {
-        int pacmanX = static_cast<int>(pacman.getX() + 0.5f);
-        int pacmanY = static_cast<int>(pacman.getY() + 0.5f);
-
-        if (map.hasPowerPoint(pacmanX, pacmanY)) {
-            map.collectCoin(pacmanX, pacmanY);
+        else if (eaten == POWER_POINT) {
+            emit(EVENT_POWER_MODE_STARTED, 50);
             score += 50;
             highScore = std::max(score, highScore);
             activatePowerMode();
@@ -171,20 +572,87 @@ public:
         ghostsVulnerable = true;
         flashTimer = 0;
 
-        std::cout << "POWER MODE ACTIVATED! Ghosts are vulnerable for 10 seconds." << std::endl;
-
         // Делаем всех призраков уязвимыми
-        for (auto& ghost : ghosts) {
-            ghost.setVulnerable(true);
+        for (size_t i = 0; i < ghosts.size(); i++) {
+            ghosts.setVulnerable(i, true);
         }
     }
 
     void checkLevelCompletion() {
-        if (map.countRemainingCoins() == 0) {
+        if (map.countRemainingCoins() == 0 && !levelComplete) {
             levelComplete = true;
+            emit(EVENT_LEVEL_COMPLETE, 0);
         }
     }
 
+    // 64-битный хеш всего состояния: позиции, направления, таймеры, флаги,
+    // генератор и монеты. Монеты (Зобрист в CoinLayer), Пакман и редкие
+    // поля призраков (линейные суммы ключ * значение) ведут свои хеши при
+    // каждой записи; позиции и таймеры призраков, которые меняются каждый
+    // тик, GhostTable дочитывает из массивов. Здесь к этому добавляются
+    // пять слов игры и генератора. Хеш только сравнивается на равенство,
+    // поэтому финальное перемешивание не нужно: оно не уменьшает числа
+    // совпадений.
+    uint64_t stateHash() const {
+        RandomState random = rng.getState();
+        int flagBits = gameOver | levelComplete << 1 | gameStarted << 2 | powerMode << 3 | ghostsVulnerable << 4;
+        return stateFieldKey(0) * random.state + stateFieldKey(1) * random.increment +
+            stateFieldKey(2) * stateHashPair(level, score) + stateFieldKey(3) * stateHashPair(powerModeTimer, highScore) +
+            stateFieldKey(4) * stateHashPair(flashTimer, flagBits) +
+            pacman.getHashSum() + ghosts.getHashSum() + map.pelletHash();
+    }
+
+    // Хеш состояния передаётся listener после каждого interval-го update()
+    // (nullptr - выключено). Listener должен жить дольше игры.
+    void setStateHashListener(StateHashListener* listener, uint32_t interval = 1) {
+        hashListener = listener;
+        hashInterval = interval > 0 ? interval : 1;
+        scheduleHash();
+    }
+
+    uint32_t getTick() const { return tick; }
+
+    // События партии (монеты, режим силы, смерти...). Игра только пишет их
+    // в кольцевой буфер; печать, звук и т.п. забирают их через drain().
+    GameEventBuffer& getEvents() { return events; }
+    const GameEventBuffer& getEvents() const { return events; }
+
+    // Полный снимок партии без выделений памяти. false - карта или число
+    // призраков не помещаются в GameState (см. MAX_GHOSTS, MAX_COIN_WORDS);
+    // игру с большим числом призраков снимает snapshot(out, extraGhosts).
+    bool snapshot(GameState& out) const {
+        if (ghosts.size() > static_cast<size_t>(MAX_GHOSTS)) return false;
+        return saveState(out, nullptr);
+    }
+
+    // Снимок с любым числом призраков: первые MAX_GHOSTS - в out.ghosts,
+    // остальные по порядку - в extraGhosts. Память выделяется, только пока
+    // вектор не дорос до нужного размера.
+    bool snapshot(GameState& out, std::vector<GhostState>& extraGhosts) const {
+        extraGhosts.resize(ghosts.size() > static_cast<size_t>(MAX_GHOSTS) ? ghosts.size() - MAX_GHOSTS : 0);
+        return saveState(out, extraGhosts.data());
+    }
+
+    // Возвращает партию к снимку. Снимок должен быть снят с игры того же
+    // размера карты; иначе false и игра не меняется.
+    bool restore(const GameState& in) {
+        if (in.ghostCount < 0 || in.ghostCount > MAX_GHOSTS) return false;
+        return loadState(in, nullptr);
+    }
+
+    // Снимок, снятый snapshot(out, extraGhosts)
+    bool restore(const GameState& in, const std::vector<GhostState>& extraGhosts) {
+        if (in.ghostCount < 0) return false;
+        size_t extra = in.ghostCount > MAX_GHOSTS ? static_cast<size_t>(in.ghostCount - MAX_GHOSTS) : 0;
+        if (extraGhosts.size() != extra) return false;
+        return loadState(in, extraGhosts.data());
+    }
+
+    // Пересевает генератор; вместе с restart() даёт воспроизводимую партию
+    void setSeed(uint64_t seed) {
+        rng.seed(seed);
+    }
+
     void setPacmanDirection(int dx, int dy) {
         if (gameOver || levelComplete) return;
         pacman.setDirection(dx, dy);
@@ -199,9 +667,9 @@ public:
         powerModeTimer = 0;
         ghostsVulnerable = false;
         map.initializeClassicMap();
-        pacman.resetPosition(map.getWidth() / 2.0f, 1.0f);
+        pacman.resetPosition(map.getWidth() * FIXED_HALF, FIXED_ONE);
         initializeGhosts();
-        pacman.setSpeed(0.1f + level * 0.01f);
+        pacman.setSpeed(PACMAN_BASE_SPEED + level * PACMAN_LEVEL_SPEEDUP);
     }
 
     void restart() {
@@ -214,14 +682,14 @@ public:
         powerModeTimer = 0;
         ghostsVulnerable = false;
         map.initializeClassicMap();
-        pacman.resetPosition(map.getWidth() / 2.0f, 1.0f);
+        pacman.resetPosition(map.getWidth() * FIXED_HALF, FIXED_ONE);
         initializeGhosts();
-        pacman.setSpeed(0.1f);
+        pacman.setSpeed(PACMAN_BASE_SPEED);
     }
 
     // Геттеры
     const Pacman& getPacman() const { return pacman; }
-    const std::vector<Ghost>& getGhosts() const { return ghosts; }
+    const GhostTable& getGhosts() const { return ghosts; }
     const GameMap& getMap() const { return map; }
     int getLevel() const { return level; }
     int getScore() const { return score; }
@@ -0,0 +1,86 @@
+#ifndef GAMEBATCH_H
+#define GAMEBATCH_H
+
+#include "game.h"
+#include "action.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Пачка независимых игр, которые двигаются синхронно на один тик за вызов.
+// Игры лежат в одном непрерывном массиве, результаты пишутся в массивы
+// вызывающей стороны, поэтому step() не выделяет память.
+class GameBatch {
+private:
+    std::vector<Game> games;
+    std::vector<int> lastScores;
+    float* rewards;
+    uint8_t* dones;
+    int* scores;
+
+public:
+    // Игра i получает seed + i
+    GameBatch(size_t count, int width, int height, uint64_t seed = 1)
+        : rewards(nullptr), dones(nullptr), scores(nullptr)
+    {
+        games.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            games.emplace_back(width, height, seed + i);
+        }
+        lastScores.assign(count, 0);
+        for (auto& game : games) {
+            game.startGame();
+        }
+    }
+
+    // Массивы результатов (по элементу на игру); любой из них может быть nullptr
+    void setOutputs(float* rewardOut, uint8_t* doneOut, int* scoreOut) {
+        rewards = rewardOut;
+        dones = doneOut;
+        scores = scoreOut;
+    }
+
+    // Двигает первые n игр на один тик. Награда - прирост очков за тик,
+    // score - счёт на конец тика (до перезапуска). Проигравшие игры
+    // перезапускаются через restart(), пройденный уровень - через nextLevel().
+    void step(const Action* actions, size_t n) {
+        if (n > games.size()) n = games.size();
+
+        for (size_t i = 0; i < n; i++) {
+            Game& game = games[i];
+            applyAction(game, actions[i]);
+            game.update();
+
+            int score = game.getScore();
+            bool done = game.isGameOver();
+            if (rewards) rewards[i] = static_cast<float>(score - lastScores[i]);
+            if (dones) dones[i] = done ? 1 : 0;
+            if (scores) scores[i] = score;
+
+            if (done) {
+                game.restart();
+                game.startGame();
+            }
+            else if (game.isLevelComplete()) {
+                game.nextLevel();
+                game.startGame();
+            }
+            lastScores[i] = game.getScore();
+        }
+    }
+
+    // Перезапускает все игры
+    void reset() {
+        for (size_t i = 0; i < games.size(); i++) {
+            games[i].restart();
+            games[i].startGame();
+            lastScores[i] = 0;
+        }
+    }
+
+    size_t size() const { return games.size(); }
+    Game& getGame(size_t i) { return games[i]; }
+    const Game& getGame(size_t i) const { return games[i]; }
+};
+
+#endif
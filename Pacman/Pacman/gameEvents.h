@@ -0,0 +1,110 @@
+#ifndef GAMEEVENTS_H
+#define GAMEEVENTS_H
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+enum GameEventType : uint8_t {
+    EVENT_COIN_EATEN,
+    EVENT_POWER_MODE_STARTED, // съеден энергетик
+    EVENT_POWER_MODE_ENDED,   // кончился таймер силы
+    EVENT_GHOST_EATEN,
+    EVENT_PACMAN_DIED,
+    EVENT_GAME_OVER,
+    EVENT_LEVEL_COMPLETE
+};
+
+struct GameEvent {
+    uint32_t tick;      // номер update(), в котором это случилось
+    GameEventType type;
+    int16_t ghost;      // индекс призрака для EVENT_GHOST_EATEN, иначе -1
+    int16_t x, y;       // клетка события (клетка Пакмана)
+    int32_t value;      // очки за событие; для EVENT_PACMAN_DIED - оставшиеся жизни
+};
+
+// Получатель событий из GameEventBuffer::drain()
+class GameEventListener {
+public:
+    virtual ~GameEventListener() {}
+    virtual void onGameEvent(const GameEvent& event) = 0;
+};
+
+// Кольцевой буфер событий игры. Память выделяется один раз в
+// конструкторе; если события никто не забирает, новые затирают самые
+// старые (считаются в getDropped()), поэтому запись события - это
+// несколько присваиваний без ввода-вывода.
+class GameEventBuffer {
+private:
+    std::vector<GameEvent> events;
+    uint32_t mask;
+    uint32_t head, tail; // счётчики записанных и прочитанных, растут без сброса
+    uint64_t dropped;
+
+public:
+    // capacity округляется вверх до степени двойки
+    explicit GameEventBuffer(uint32_t capacity = 256) : head(0), tail(0), dropped(0) {
+        uint32_t size = 1;
+        while (size < capacity) size <<= 1;
+        events.resize(size);
+        mask = size - 1;
+    }
+
+    void push(const GameEvent& event) {
+        if (head - tail > mask) {
+            tail++;
+            dropped++;
+        }
+        events[head & mask] = event;
+        head++;
+    }
+
+    bool pop(GameEvent& out) {
+        if (head == tail) return false;
+        out = events[tail & mask];
+        tail++;
+        return true;
+    }
+
+    // Отдаёт listener все накопленные события по порядку
+    void drain(GameEventListener& listener) {
+        while (head != tail) {
+            listener.onGameEvent(events[tail & mask]);
+            tail++;
+        }
+    }
+
+    void clear() { tail = head; }
+
+    uint32_t size() const { return head - tail; }
+    uint32_t capacity() const { return mask + 1; }
+    uint64_t getDropped() const { return dropped; }
+};
+
+// Прежний лог игры в консоль. Каждое событие - одна строка одним вызовом
+// printf, поэтому строки разных потоков не перемешиваются посередине;
+// tag >= 0 (например, сид партии) печатается в начале строки.
+class ConsoleEventLog : public GameEventListener {
+private:
+    long long tag;
+
+public:
+    explicit ConsoleEventLog(long long tag = -1) : tag(tag) {}
+
+    void onGameEvent(const GameEvent& event) override {
+        const char* text = nullptr;
+        switch (event.type) {
+        case EVENT_POWER_MODE_STARTED: text = "POWER MODE ACTIVATED! Ghosts are vulnerable for 10 seconds."; break;
+        case EVENT_POWER_MODE_ENDED:   text = "POWER MODE ENDED!"; break;
+        case EVENT_GHOST_EATEN:        text = "Pacman ate ghost! Score +200"; break;
+        case EVENT_PACMAN_DIED:        text = "Pacman died!"; break;
+        case EVENT_GAME_OVER:          text = "GAME OVER!"; break;
+        case EVENT_LEVEL_COMPLETE:     text = "LEVEL COMPLETE!"; break;
+        default: return; // монеты слишком частые для консоли
+        }
+        if (tag >= 0) std::printf("[%lld] %s\n", tag, text);
+        else std::printf("%s\n", text);
+    }
+};
+
+#endif
@@ -2,154 +2,186 @@
 #define GAMEMAP_H
 
 #include "cell.h"
-#include "coin.h"
+#include "coinLayer.h"
+#include "mazeGraph.h"
+#include "distanceTable.h"
+#include "gameState.h"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
 #include <vector>
-#include <cstdlib>
-#include <ctime>
 
-class GameMap {
+// Байт клетки: младшие 4 бита - CellType, старшие 4 - маска выходов
+const uint8_t CELL_TYPE_MASK = 0x0F;
+const int CELL_EXITS_SHIFT = 4;
+
+// Лёгкое представление сетки для рендера: только чтение, без копирования
+class GridView {
 private:
-    std::vector<std::vector<Cell>> grid;
-    int width, height;
+    const uint8_t* cells;
+    const CoinLayer* coins;
+    const CoinLayer* powerPoints;
+    int width, height, stride;
 
 public:
-    GameMap(int w, int h) : width(w), height(h) {
-        grid.resize(height, std::vector<Cell>(width));
-        std::srand(std::time(0));
-        initializeClassicMap();
-    }
-   
-    void initializeClassicMap() {
-        
-        for (int i = 0; i < height; i++) {
-            for (int j = 0; j < width; j++) {
-                grid[i][j] = Cell(j, i, EMPTY);
-            }
-        }
-        createClassicWalls();
-        createCoins();
-        createPowerPoints(); 
+    GridView(const uint8_t* cells, const CoinLayer* coins, const CoinLayer* powerPoints,
+        int width, int height, int stride)
+        : cells(cells), coins(coins), powerPoints(powerPoints),
+        width(width), height(height), stride(stride) {}
+
+    CellType at(int x, int y) const {
+        int i = (y + 1) * stride + (x + 1);
+        if ((cells[i] & CELL_TYPE_MASK) == WALL) return WALL;
+        if (coins->test(i)) return COIN;
+        if (powerPoints->test(i)) return POWER_POINT;
+        return EMPTY;
     }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+};
+
+// Неизменная часть карты: сетка по байту на клетку и граф развилок.
+// Стены классической карты зависят только от размера, поэтому все карты
+// одного размера делят один MazeLayout (см. get), а своими у GameMap
+// остаются только монеты и энергетики.
+class MazeLayout {
+private:
+    // Одна непрерывная сетка, вокруг карты рамка из стен толщиной в клетку.
+    // Рамка заменяет проверки границ: соседи любой клетки карты (и сами
+    // координаты -1 и width/height) всегда лежат внутри массива. Вместе с
+    // типом клетки хранится готовая маска выходов: движению и ИИ хватает
+    // одного байта вместо нескольких проверок соседей.
+    std::vector<uint8_t> cells;
+    int width, height;
+    int stride;
+    MazeGraph graph;
+
+    int index(int x, int y) const { return (y + 1) * stride + (x + 1); }
+    uint8_t& at(int x, int y) { return cells[index(x, y)]; }
+    CellType typeAt(int x, int y) const { return static_cast<CellType>(cells[index(x, y)] & CELL_TYPE_MASK); }
 
     void createClassicWalls() {
         // Внешние стены
         for (int i = 0; i < height; i++) {
-            grid[i][0].type = WALL;
-            grid[i][width - 1].type = WALL;
+            at(0, i) = WALL;
+            at(width - 1, i) = WALL;
         }
         for (int j = 0; j < width; j++) {
-            grid[0][j].type = WALL;
-            grid[height - 1][j].type = WALL;
+            at(j, 0) = WALL;
+            at(j, height - 1) = WALL;
         }
 
         // Простая классическая карта Pac-Man
         // Вертикальные стены
         for (int i = 1; i <= 5; i++) {
-            grid[i][3].type = WALL;
-            grid[i][width - 4].type = WALL;
+            at(3, i) = WALL;
+            at(width - 4, i) = WALL;
         }
 
         for (int i = height - 6; i <= height - 2; i++) {
-            grid[i][3].type = WALL;
-            grid[i][width - 4].type = WALL;
+            at(3, i) = WALL;
+            at(width - 4, i) = WALL;
         }
 
         // Угловые блоки
-        grid[5][5].type = WALL;
-        grid[5][6].type = WALL;
-        grid[6][5].type = WALL;
+        at(5, 5) = WALL;
+        at(6, 5) = WALL;
+        at(5, 6) = WALL;
 
-        grid[5][width - 6].type = WALL;
-        grid[5][width - 7].type = WALL;
-        grid[6][width - 6].type = WALL;
+        at(width - 6, 5) = WALL;
+        at(width - 7, 5) = WALL;
+        at(width - 6, 6) = WALL;
 
-        grid[height - 6][5].type = WALL;
-        grid[height - 6][6].type = WALL;
-        grid[height - 7][5].type = WALL;
+        at(5, height - 6) = WALL;
+        at(6, height - 6) = WALL;
+        at(5, height - 7) = WALL;
 
-        grid[height - 6][width - 6].type = WALL;
-        grid[height - 6][width - 7].type = WALL;
-        grid[height - 7][width - 6].type = WALL;
+        at(width - 6, height - 6) = WALL;
+        at(width - 7, height - 6) = WALL;
+        at(width - 6, height - 7) = WALL;
 
 
         
         
-        grid[8][3].type = WALL;
-        grid[9][3].type = WALL;
-        grid[10][3].type = WALL;
-        grid[10][2].type = WALL;
+        at(3, 8) = WALL;
+        at(3, 9) = WALL;
+        at(3, 10) = WALL;
+        at(2, 10) = WALL;
 
-        grid[11][3].type = WALL;
-        grid[12][3].type = WALL;
+        at(3, 11) = WALL;
+        at(3, 12) = WALL;
 
 
-        grid[8][15].type = WALL;
-        grid[9][15].type = WALL;
-        grid[10][15].type = WALL;
-        grid[10][16].type = WALL;
-        grid[11][15].type = WALL;
-        grid[12][15].type = WALL;
+        at(15, 8) = WALL;
+        at(15, 9) = WALL;
+        at(15, 10) = WALL;
+        at(16, 10) = WALL;
+        at(15, 11) = WALL;
+        at(15, 12) = WALL;
 
-        grid[19][2].type = WALL;
-        grid[19][4].type = WALL;
+        at(2, 19) = WALL;
+        at(4, 19) = WALL;
        
-        grid[1][2].type = WALL;
-        grid[1][4].type = WALL;
+        at(2, 1) = WALL;
+        at(4, 1) = WALL;
 
-        grid[1][16].type = WALL;
-        grid[1][14].type = WALL;
+        at(16, 1) = WALL;
+        at(14, 1) = WALL;
 
 
 
-        grid[1][6].type = WALL;
-        grid[2][6].type = WALL;
-        grid[3][6].type = WALL;
-        grid[4][6].type = WALL;
+        at(6, 1) = WALL;
+        at(6, 2) = WALL;
+        at(6, 3) = WALL;
+        at(6, 4) = WALL;
 
 
-        grid[1][12].type = WALL;
-        grid[2][12].type = WALL;
-        grid[3][12].type = WALL;
-        grid[4][12].type = WALL;
+        at(12, 1) = WALL;
+        at(12, 2) = WALL;
+        at(12, 3) = WALL;
+        at(12, 4) = WALL;
 
        
 
 
-        grid[16][6].type = WALL;
-        grid[17][6].type = WALL;
-        grid[18][6].type = WALL;
-        grid[19][6].type = WALL;
+        at(6, 16) = WALL;
+        at(6, 17) = WALL;
+        at(6, 18) = WALL;
+        at(6, 19) = WALL;
 
-        grid[16][12].type = WALL;
-        grid[17][12].type = WALL;
-        grid[18][12].type = WALL;
-        grid[19][12].type = WALL;
+        at(12, 16) = WALL;
+        at(12, 17) = WALL;
+        at(12, 18) = WALL;
+        at(12, 19) = WALL;
 
         
-        grid[19][16].type = WALL;
-        grid[19][14].type = WALL;
+        at(16, 19) = WALL;
+        at(14, 19) = WALL;
 
 
-        grid[10][10].type = WALL;
-        grid[10][9].type = WALL;
+        at(10, 10) = WALL;
+        at(9, 10) = WALL;
 
 
-        grid[11][9].type = WALL;
-        grid[12][9].type = WALL;
-        grid[13][9].type = WALL;
+        at(9, 11) = WALL;
+        at(9, 12) = WALL;
+        at(9, 13) = WALL;
 
 
-        grid[9][9].type = WALL;
-        grid[8][9].type = WALL;
-        grid[7][9].type = WALL;
+        at(9, 9) = WALL;
+        at(9, 8) = WALL;
+        at(9, 7) = WALL;
 
 
 
 
-        grid[10][8].type = WALL;
-        grid[10][7].type = WALL;
-        grid[10][10].type = WALL;
-        grid[10][11].type = WALL;
+        at(8, 10) = WALL;
+        at(7, 10) = WALL;
+        at(10, 10) = WALL;
+        at(11, 10) = WALL;
 
 
 
@@ -164,71 +196,272 @@ public:
 
     }
 
+    // Маски выходов для всех клеток карты (рамка остаётся без выходов)
+    void buildExitMasks() {
+        for (int i = 0; i < height; i++) {
+            for (int j = 0; j < width; j++) {
+                uint8_t exits = 0;
+                for (int d = 0; d < 4; d++) {
+                    if (isWalkable(typeAt(j + MAZE_DIRECTIONS[d][0], i + MAZE_DIRECTIONS[d][1]))) {
+                        exits |= static_cast<uint8_t>(1 << d);
+                    }
+                }
+                uint8_t& cell = at(j, i);
+                cell = static_cast<uint8_t>((cell & CELL_TYPE_MASK) | (exits << CELL_EXITS_SHIFT));
+            }
+        }
+    }
+
+public:
+    MazeLayout(int w, int h) : width(w), height(h), stride(w + 2) {
+        cells.assign(static_cast<size_t>(stride) * (height + 2), WALL);
+        for (int i = 0; i < height; i++) {
+            for (int j = 0; j < width; j++) {
+                at(j, i) = EMPTY;
+            }
+        }
+        createClassicWalls();
+        // Энергетик заменяет всё, что было в клетке, в том числе стену
+        forEachPowerPointCell(width, height, [this](int x, int y) { at(x, y) = EMPTY; });
+        buildExitMasks();
+        graph.build(*this);
+    }
+
+    // Клетки энергетиков классической карты
+    template <typename Fn>
+    static void forEachPowerPointCell(int width, int height, Fn fn) {
+        fn(1, 1);                    // Левый верхний угол
+        fn(width - 2, 1);            // Правый верхний угол
+        fn(1, height - 2);           // Левый нижний угол
+        fn(width - 2, height - 2);   // Правый нижний угол
+    }
+
+    // Общий layout размера w x h: строится для первой карты этого размера
+    // и живёт, пока жива хоть одна такая карта
+    static std::shared_ptr<const MazeLayout> get(int w, int h) {
+        static std::mutex mutex;
+        static std::map<std::pair<int, int>, std::weak_ptr<const MazeLayout>> cache;
+        std::lock_guard<std::mutex> lock(mutex);
+        std::weak_ptr<const MazeLayout>& slot = cache[std::make_pair(w, h)];
+        std::shared_ptr<const MazeLayout> layout = slot.lock();
+        if (!layout) {
+            layout = std::make_shared<const MazeLayout>(w, h);
+            slot = layout;
+        }
+        return layout;
+    }
+
+    // Для MazeGraph::build
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    bool canMove(float fx, float fy) const {
+        return isWalkable(typeAt(static_cast<int>(fx), static_cast<int>(fy)));
+    }
+    uint8_t exitMask(int x, int y) const {
+        return static_cast<uint8_t>(cells[index(x, y)] >> CELL_EXITS_SHIFT);
+    }
+
+    const uint8_t* data() const { return cells.data(); }
+    size_t size() const { return cells.size(); }
+    const MazeGraph& getGraph() const { return graph; }
+
+    // Сетка и заголовок; граф считается отдельно
+    size_t memoryUsage() const {
+        return sizeof(MazeLayout) + cells.capacity() * sizeof(uint8_t);
+    }
+};
+
+class GameMap {
+private:
+    // Сетка стен (общая, см. MazeLayout) и указатель на её байты. В сетке
+    // только стены и пустые клетки, монеты лежат в битовых слоях с той же
+    // индексацией.
+    std::shared_ptr<const MazeLayout> layout;
+    const uint8_t* cells;
+    CoinLayer coins;
+    CoinLayer powerPoints;
+    int width, height;
+    int stride;
+    // Растёт при каждой расстановке стен: по нему отрисовка узнаёт, что
+    // запечённый меш стен пора собрать заново
+    uint32_t wallVersion;
+    // Таблица расстояний строится по запросу (buildDistanceTable) и тоже делится
+    std::shared_ptr<const DistanceTable> distanceTable;
+
+    int index(int x, int y) const { return (y + 1) * stride + (x + 1); }
+    CellType typeAt(int x, int y) const { return static_cast<CellType>(cells[index(x, y)] & CELL_TYPE_MASK); }
+
+public:
+    GameMap(int w, int h)
+        : layout(MazeLayout::get(w, h)), cells(layout->data()), coins(0), powerPoints(0x100000000ULL),
+        width(w), height(h), stride(w + 2), wallVersion(0) {
+        coins.resize(layout->size());
+        powerPoints.resize(layout->size());
+        initializeClassicMap();
+    }
+   
+    // Монеты и энергетики заново. Стены лежат в общем MazeLayout и не
+    // меняются; wallVersion всё равно растёт - отрисовка по нему узнаёт
+    // о новом уровне
+    void initializeClassicMap() {
+        coins.clear();
+        powerPoints.clear();
+        createCoins();
+        createPowerPoints();
+        wallVersion++;
+    }
 
     void createCoins() {
         for (int i = 0; i < height; i++) {
             for (int j = 0; j < width; j++) {
-                if (grid[i][j].type == EMPTY) {
-                    grid[i][j] = Coin::createCoinCell(j, i);
+                if (typeAt(j, i) == EMPTY) {
+                    coins.set(index(j, i));
                 }
             }
         }
     }
 
     void createPowerPoints() {
-        // Размещаем POWER_POINT  углах карты
-        grid[1][1].type = POWER_POINT;                    // Левый верхний угол
-        grid[1][width - 2].type = POWER_POINT;            // Правый верхний угол
-        grid[height - 2][1].type = POWER_POINT;           // Левый нижний угол
-        grid[height - 2][width - 2].type = POWER_POINT;   // Правый нижний угол
+        MazeLayout::forEachPowerPointCell(width, height, [this](int x, int y) { placePowerPoint(x, y); });
+    }
+
+    // Энергетик заменяет монету в клетке (стену под ним убирает MazeLayout)
+    void placePowerPoint(int x, int y) {
+        int i = index(x, y);
+        coins.testAndClear(i);
+        powerPoints.set(i);
     }
 
+    // Координаты запросов ниже должны лежать в пределах [-1, width] x [-1, height]:
+    // дальше рамки проверок нет
     bool canMove(float fx, float fy) const {
-        int x = static_cast<int>(fx);
-        int y = static_cast<int>(fy);
-        if (x < 0 || x >= width || y < 0 || y >= height) {
-            return false;
-        }
-        return grid[y][x].isWalkable();
+        return canEnter(static_cast<int>(fx), static_cast<int>(fy));
+    }
+
+    // Можно ли стоять в клетке (x, y)
+    bool canEnter(int x, int y) const {
+        return isWalkable(typeAt(x, y));
+    }
+
+    // Биты MAZE_DIRECTIONS, в которые из клетки (x, y) можно шагнуть
+    uint8_t exitMask(int x, int y) const {
+        return static_cast<uint8_t>(cells[index(x, y)] >> CELL_EXITS_SHIFT);
+    }
+
+    // То же, что canMove(x + dx, y + dy), но для единичного шага - по маске выходов
+    bool canStep(int x, int y, int dx, int dy) const {
+        int d = directionIndex(dx, dy);
+        if (d < 0) return canEnter(x + dx, y + dy);
+        return (exitMask(x, y) >> d) & 1;
+    }
+
+    // Забирает монету или энергетик из клетки и возвращает, что там было
+    // (COIN, POWER_POINT или EMPTY)
+    CellType collectAt(int x, int y) {
+        int i = index(x, y);
+        if (coins.testAndClear(i)) return COIN;
+        if (powerPoints.testAndClear(i)) return POWER_POINT;
+        return EMPTY;
     }
 
     void collectCoin(int x, int y) {
-        if (x >= 0 && x < width && y >= 0 && y < height) {
-            if (grid[y][x].type == COIN || grid[y][x].type == POWER_POINT) {
-                grid[y][x].type = EMPTY;
-            }
-        }
+        collectAt(x, y);
     }
 
     bool hasCoin(int x, int y) const {
-        if (x < 0 || x >= width || y < 0 || y >= height) {
-            return false;
-        }
-        return grid[y][x].type == COIN;
+        return coins.test(index(x, y));
     }
 
     bool hasPowerPoint(int x, int y) const {
-        if (x < 0 || x >= width || y < 0 || y >= height) {
-            return false;
-        }
-        return grid[y][x].type == POWER_POINT;
+        return powerPoints.test(index(x, y));
     }
 
     int getWidth() const { return width; }
     int getHeight() const { return height; }
 
-    const std::vector<std::vector<Cell>>& getGrid() const {
-        return grid;
+    GridView getGrid() const {
+        return GridView(cells, &coins, &powerPoints, width, height, stride);
     }
 
-    int countRemainingCoins() const {
-        int count = 0;
-        for (const auto& row : grid) {
-            for (const auto& cell : row) {
-                if (cell.type == COIN || cell.type == POWER_POINT) count++;
-            }
+    // Битовые слои для обхода по словам; индекс бита - (y + 1) * stride + (x + 1)
+    const CoinLayer& getCoins() const { return coins; }
+    const CoinLayer& getPowerPoints() const { return powerPoints; }
+    int getStride() const { return stride; }
+    uint32_t getWallVersion() const { return wallVersion; }
+
+    const MazeGraph& getGraph() const { return layout->getGraph(); }
+    const MazeLayout& getLayout() const { return *layout; }
+
+    // Строит таблицу кратчайших расстояний между всеми проходимыми клетками
+    // на threads потоках (0 - все ядра). Перестраивать после
+    // initializeClassicMap не нужно: стены те же.
+    bool buildDistanceTable(int threads = 0) {
+        std::shared_ptr<DistanceTable> table = std::make_shared<DistanceTable>();
+        ParallelRunner runner(threads);
+        if (!table->build(*this, runner)) return false;
+        distanceTable = table;
+        return true;
+    }
+
+    // nullptr, пока таблица не построена
+    const DistanceTable* getDistanceTable() const { return distanceTable.get(); }
+
+    // Расстояние по лабиринту в шагах; -1, если пути нет или таблица не построена
+    int mazeDistance(int fromX, int fromY, int toX, int toY) const {
+        return distanceTable ? distanceTable->distance(fromX, fromY, toX, toY) : -1;
+    }
+
+    // Вызывают fn(x, y) для каждой оставшейся монеты / энергетика
+    template <typename Fn>
+    void forEachCoin(Fn fn) const {
+        int s = stride;
+        coins.forEach([&fn, s](int i) { fn(i % s - 1, i / s - 1); });
+    }
+
+    template <typename Fn>
+    void forEachPowerPoint(Fn fn) const {
+        int s = stride;
+        powerPoints.forEach([&fn, s](int i) { fn(i % s - 1, i / s - 1); });
+    }
+
+    // Монеты и энергетики в снимок; false, если карта не помещается в MapState
+    bool saveState(MapState& out) const {
+        out.width = width;
+        out.height = height;
+        out.wordCount = static_cast<int32_t>(coins.wordCount());
+        out.coinCount = coins.getCount();
+        out.powerPointCount = powerPoints.getCount();
+        out.coinHash = coins.getHash();
+        out.powerPointHash = powerPoints.getHash();
+        return coins.saveWords(out.coins, MAX_COIN_WORDS) &&
+            powerPoints.saveWords(out.powerPoints, MAX_COIN_WORDS);
+    }
+
+    // Снимок должен быть снят с карты того же размера
+    bool loadState(const MapState& in) {
+        if (in.width != width || in.height != height ||
+            in.wordCount != static_cast<int32_t>(coins.wordCount())) {
+            return false;
         }
-        return count;
+        coins.loadWords(in.coins, in.coinCount, in.coinHash);
+        powerPoints.loadWords(in.powerPoints, in.powerPointCount, in.powerPointHash);
+        return true;
+    }
+
+    // Сколько байт занимает сама карта вместе с монетами; общий с другими
+    // картами того же размера MazeLayout считает getLayout().memoryUsage()
+    size_t memoryUsage() const {
+        return sizeof(GameMap) + (coins.wordCount() + powerPoints.wordCount()) * sizeof(uint64_t);
+    }
+
+    // Хеш Зобриста оставшихся монет и энергетиков, O(1)
+    uint64_t pelletHash() const {
+        return coins.getHash() ^ powerPoints.getHash();
+    }
+
+    // Монеты и энергетики вместе; счётчики ведутся при сборе, поэтому O(1)
+    int countRemainingCoins() const {
+        return coins.getCount() + powerPoints.getCount();
     }
 };
 
@@ -0,0 +1,75 @@
+#ifndef GAMESTATE_H
+#define GAMESTATE_H
+
+#include "random.h"
+#include <cstdint>
+#include <type_traits>
+
+// Плоские копии состояния игры для поиска, откатов и повторов.
+// Без указателей и векторов: снимок копируется одним memcpy.
+
+// Призраков в самом снимке; остальные идут отдельным массивом GhostState
+// (Game::snapshot с extraGhosts). Больше монетных слов - snapshot() вернёт false
+const int MAX_GHOSTS = 4;
+const int MAX_COIN_WORDS = 16; // 1024 клетки с рамкой, классической карте нужно 8
+
+struct PacmanState {
+    int32_t x, y;
+    int32_t startX, startY;
+    int32_t dx, dy;
+    int32_t nextDx, nextDy;
+    int32_t speed;
+    int32_t lives;
+    int32_t mouthTick;
+    int32_t rotationY;
+};
+
+struct GhostState {
+    int32_t x, y;
+    int32_t speed;
+    int32_t dx, dy;
+    int32_t respawnX, respawnY;
+    int32_t frightenedTimer;
+    int32_t modeTimer;
+    int32_t scatterChaseCycle;
+    uint8_t color;
+    uint8_t vulnerable;
+    uint8_t inScatterMode;
+    uint8_t modeJustChanged;
+};
+
+// Монеты и энергетики: слова битовых слоёв GameMap и их счётчики.
+// Стены в снимок не входят - они задаются размером карты.
+struct MapState {
+    int32_t width, height;
+    int32_t wordCount;
+    int32_t coinCount;
+    int32_t powerPointCount;
+    uint64_t coinHash;
+    uint64_t powerPointHash;
+    uint64_t coins[MAX_COIN_WORDS];
+    uint64_t powerPoints[MAX_COIN_WORDS];
+};
+
+struct GameState {
+    RandomState rng;
+    int32_t level;
+    int32_t score;
+    int32_t highScore;
+    int32_t powerModeTimer;
+    int32_t flashTimer;
+    uint8_t gameOver;
+    uint8_t levelComplete;
+    uint8_t gameStarted;
+    uint8_t powerMode;
+    uint8_t ghostsVulnerable;
+    uint32_t tick;
+    int32_t ghostCount;
+    PacmanState pacman;
+    GhostState ghosts[MAX_GHOSTS];
+    MapState map;
+};
+
+static_assert(std::is_trivially_copyable<GameState>::value, "GameState must be copyable with memcpy");
+
+#endif
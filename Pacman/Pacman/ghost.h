@@ -3,11 +3,16 @@
 
 #include "gameMap.h"
 #include "pacman.h"
-#include <cmath>
-#include <vector>
-#include <cstdlib>
+#include "random.h"
+#include "fixed.h"
+#include "gameState.h"
+#include "ghostPositions.h"
+#include "stateHash.h"
+#include <cstddef>
+#include <cstdint>
 #include <algorithm>
-#include <iostream>
+#include <utility>
+#include <vector>
 
 enum GhostColor {
     RED,    // Blinky
@@ -16,44 +21,99 @@ enum GhostColor {
     ORANGE  // Clyde
 };
 
-class Ghost {
+// Биты GhostTable::flags
+enum GhostFlags : uint8_t {
+    GHOST_VULNERABLE = 1,
+    GHOST_SCATTER = 2,      // режим scatter, иначе chase
+    GHOST_MODE_CHANGED = 4  // режим сменился: разворот в ближайшем центре клетки
+};
+
+class Ghost;
+
+// Все призраки игры структурой массивов: у каждого поля свой массив по
+// номеру призрака. Копий состояния нет - ход призраков, перемотка и
+// проверка касаний (getPositions().firstContact) читают одни и те же
+// массивы. Логика призрака - методы таблицы с номером призрака.
+// Хеш: поля, меняющиеся почти каждый тик (позиция, таймеры), getHashSum
+// читает из массивов; остальные пишутся через set*, которые поправляют
+// rowHashes.
+class GhostTable {
 private:
-    float x, y;
-    float speed;
-    int dx, dy;
-    bool vulnerable;
-    float respawnX, respawnY;
-    GhostColor color;
-    int frightenedTimer;
-    int modeTimer;
-    bool inScatterMode;
-    int scatterChaseCycle; // Счётчик циклов scatter/chase
-    bool modeJustChanged;  // Флаг смены режима для принудительного разворота
+    // Номера полей для stateFieldKey
+    enum HashField {
+        HASH_SPEED, HASH_DX, HASH_DY, HASH_RESPAWN_X, HASH_RESPAWN_Y, HASH_CYCLE, HASH_COLOR, HASH_FLAGS,
+        HASH_ROW_FIELD_COUNT, // выше - в rowHashes, ниже - в getHashSum
+        HASH_POSITION = HASH_ROW_FIELD_COUNT, // x и y одним словом
+        HASH_TIMERS,                          // frightenedTimer и modeTimer одним словом
+        HASH_FIELD_COUNT
+    };
+
+    GhostPositions positions;           // x, y в единицах FIXED_ONE
+    std::vector<int32_t> speeds;        // единиц FIXED_ONE за тик
+    std::vector<int8_t> dxs, dys;
+    std::vector<int32_t> respawnXs, respawnYs;
+    std::vector<int32_t> frightenedTimers;
+    std::vector<int32_t> modeTimers;
+    std::vector<int32_t> scatterChaseCycles; // Счётчик циклов scatter/chase
+    std::vector<uint8_t> colors;
+    std::vector<uint8_t> flags;         // GhostFlags
+    std::vector<uint64_t> rowHashes;    // сумма ключ * значение по редким полям призрака
+
+    // Запись в столбец с поправкой хеша на разность значений; ключ поля -
+    // параметр шаблона, чтобы считался при компиляции
+    template <HashField F, typename T>
+    void set(std::vector<T>& column, size_t i, int value) {
+        constexpr uint64_t fieldKey = stateFieldKey(STATE_KEYS_GHOSTS + F);
+        rowHashes[i] += fieldKey * (static_cast<uint64_t>(value) - static_cast<uint64_t>(column[i]));
+        column[i] = static_cast<T>(value);
+    }
+
+    void setDirection(size_t i, int dx, int dy) {
+        set<HASH_DX>(dxs, i, dx);
+        set<HASH_DY>(dys, i, dy);
+    }
+
+    // rowHashes[i] с нуля
+    uint64_t rowHash(size_t i) const {
+        const int fields[HASH_ROW_FIELD_COUNT] = {
+            speeds[i], dxs[i], dys[i], respawnXs[i], respawnYs[i], scatterChaseCycles[i], colors[i], flags[i]
+        };
+        uint64_t sum = 0;
+        for (int f = 0; f < HASH_ROW_FIELD_COUNT; f++) {
+            sum += stateFieldKey(STATE_KEYS_GHOSTS + f) * static_cast<uint64_t>(fields[f]);
+        }
+        return sum;
+    }
+
+    bool hasFlag(size_t i, uint8_t flag) const { return (flags[i] & flag) != 0; }
+
+    void setFlag(size_t i, uint8_t flag, bool on) {
+        set<HASH_FLAGS>(flags, i, on ? (flags[i] | flag) : (flags[i] & ~flag));
+    }
 
     // Получаем целочисленные координаты текущей клетки
-    int getCurrentTileX() const { return static_cast<int>(std::round(x)); }
-    int getCurrentTileY() const { return static_cast<int>(std::round(y)); }
+    int getCurrentTileX(size_t i) const { return fixedRoundToTile(positions.getX(i)); }
+    int getCurrentTileY(size_t i) const { return fixedRoundToTile(positions.getY(i)); }
 
-    // Проверяем, находится ли призрак в центре клетки
-    bool isAtIntersection() const {
-        return std::abs(x - getCurrentTileX()) < 0.05f &&
-            std::abs(y - getCurrentTileY()) < 0.05f;
+    // Проверяем, находится ли призрак в центре клетки. Движение не
+    // перескакивает центры (см. update), поэтому проверка точная.
+    bool isAtIntersection(size_t i) const {
+        return fixedIsCentered(positions.getX(i)) && fixedIsCentered(positions.getY(i));
     }
 
     // Выравниваем позицию к центру клетки
-    void alignToGrid() {
-        x = getCurrentTileX();
-        y = getCurrentTileY();
+    void alignToGrid(size_t i) {
+        positions.set(i, fixedFromTile(getCurrentTileX(i)), fixedFromTile(getCurrentTileY(i)));
     }
 
     // Получаем целевую позицию для преследования
-    std::pair<int, int> getChaseTarget(const Pacman& pacman) {
-        int pacmanX = static_cast<int>(std::round(pacman.getX()));
-        int pacmanY = static_cast<int>(std::round(pacman.getY()));
+    std::pair<int, int> getChaseTarget(size_t i, const Pacman& pacman) const {
+        int pacmanX = fixedRoundToTile(pacman.getFixedX());
+        int pacmanY = fixedRoundToTile(pacman.getFixedY());
         int pacmanDx = pacman.getDirectionX();
         int pacmanDy = pacman.getDirectionY();
 
-        switch (color) {
+        switch (colors[i]) {
         case RED: // Blinky - прямое преследование
             return { pacmanX, pacmanY };
 
@@ -63,8 +123,8 @@ private:
         case CYAN: // Inky - зеркальная позиция относительно Blinky
         {
             // Более точная версия Inky
-            int blinkyX = getCurrentTileX(); // Примерно позиция Blinky
-            int blinkyY = getCurrentTileY();
+            int blinkyX = getCurrentTileX(i); // Примерно позиция Blinky
+            int blinkyY = getCurrentTileY(i);
             int targetX = pacmanX + pacmanDx * 2;
             int targetY = pacmanY + pacmanDy * 2;
             return { targetX + (targetX - blinkyX), targetY + (targetY - blinkyY) };
@@ -72,10 +132,10 @@ private:
 
         case ORANGE: // Clyde - преследует на расстоянии, убегает вблизи
         {
-            float distance = std::sqrt(std::pow(x - pacman.getX(), 2) +
-                std::pow(y - pacman.getY(), 2));
-            if (distance < 8.0f) {
-                return getScatterTarget(); // Убегает в свой scatter-угол
+            const int64_t scareRadius = fixedFromTile(8);
+            if (fixedDistanceSquared(positions.getX(i), positions.getY(i), pacman.getFixedX(), pacman.getFixedY()) <
+                scareRadius * scareRadius) {
+                return getScatterTarget(i); // Убегает в свой scatter-угол
             }
             else {
                 return { pacmanX, pacmanY };
@@ -86,8 +146,8 @@ private:
     }
 
     // Получаем целевую позицию для режима scatter
-    std::pair<int, int> getScatterTarget() {
-        switch (color) {
+    std::pair<int, int> getScatterTarget(size_t i) const {
+        switch (colors[i]) {
         case RED:    return { 25, -3 };   // Правый верхний (за картой)
         case PINK:   return { 2, -3 };    // Левый верхний (за картой)
         case CYAN:   return { 27, 30 };   // Правый нижний (за картой)
@@ -97,258 +157,578 @@ private:
     }
 
     // Проверяем специальные ограничения для туннелей
-    bool isRestrictedTunnel(int tileX, int tileY) const {
+    static bool isRestrictedTunnel(int tileX, int tileY) {
         // Желтые клетки где нельзя поворачивать вверх
         return (tileY == 17 && (tileX == 12 || tileX == 15));
     }
 
     // Выбираем лучшее направление движения согласно оригинальной механике
-    void chooseBestDirection(const GameMap& map, const Pacman& pacman) {
-        if (!isAtIntersection()) {
+    void chooseBestDirection(size_t i, const GameMap& map, const Pacman& pacman, Random& rng) {
+        if (!isAtIntersection(i)) {
             return;
         }
 
-        alignToGrid();
+        alignToGrid(i);
 
         // Принудительный разворот при смене режима (кроме выхода из frightened)
-        if (modeJustChanged && !vulnerable) {
-            dx = -dx;
-            dy = -dy;
-            modeJustChanged = false;
+        if (hasFlag(i, GHOST_MODE_CHANGED) && !hasFlag(i, GHOST_VULNERABLE)) {
+            setDirection(i, -dxs[i], -dys[i]);
+            setFlag(i, GHOST_MODE_CHANGED, false);
             return;
         }
 
-        std::pair<int, int> target;
-        if (vulnerable) {
+        int dx = dxs[i], dy = dys[i];
+        int tileX = getCurrentTileX(i), tileY = getCurrentTileY(i);
+        if (hasFlag(i, GHOST_VULNERABLE)) {
             // В режиме испуга - случайное движение
-            chooseRandomDirection(map);
-            return;
-        }
-        else if (inScatterMode) {
-            target = getScatterTarget();
+            steerRandomly(map, tileX, tileY, rng, dx, dy);
         }
         else {
-            target = getChaseTarget(pacman);
+            std::pair<int, int> target = hasFlag(i, GHOST_SCATTER) ? getScatterTarget(i) : getChaseTarget(i, pacman);
+            steerToTarget(map, tileX, tileY, target.first, target.second,
+                isRestrictedTunnel(tileX, tileY), dx, dy);
         }
+        setDirection(i, dx, dy);
+    }
 
-        // Все возможные направления с приоритетами
-        std::vector<std::pair<int, int>> directions = {
-            {0, -1},  // Вверх (наивысший приоритет)
-            {-1, 0},   // Влево
-            {0, 1},    // Вниз  
-            {1, 0}     // Вправо (наименьший приоритет)
-        };
-
-        std::vector<std::pair<int, int>> validDirections;
-        std::vector<float> distances;
+    void updateMode(size_t i) {
+        if (hasFlag(i, GHOST_VULNERABLE)) {
+            frightenedTimers[i]--;
+            if (frightenedTimers[i] <= 0) {
+                setFlag(i, GHOST_VULNERABLE, false);
+                // При выходе из frightened НЕ разворачиваемся
+            }
+        }
 
-        int currentX = getCurrentTileX();
-        int currentY = getCurrentTileY();
+        // Обновляем таймер режима
+        modeTimers[i]--;
 
-        for (const auto& dir : directions) {
-            int newDx = dir.first;
-            int newDy = dir.second;
+        // Волны scatter/chase согласно оригинальной механике
+        if (modeTimers[i] <= 0) {
+            if (hasFlag(i, GHOST_SCATTER)) {
+                // Завершился scatter-режим, переходим в chase
+                setFlag(i, GHOST_SCATTER, false);
+                set<HASH_CYCLE>(scatterChaseCycles, i, scatterChaseCycles[i] + 1);
 
-            // Запрещаем обратное направление (кроме случаев когда нет выбора)
-            if (newDx == -dx && newDy == -dy) {
-                continue;
+                // Устанавливаем длительность chase-режима
+                if (scatterChaseCycles[i] < 4) {
+                    modeTimers[i] = 20 * 60; // 20 секунд (60 FPS)
+                }
+                else {
+                    modeTimers[i] = -1; // Бесконечный chase
+                }
             }
+            else {
+                // Завершился chase-режим, переходим в scatter
+                setFlag(i, GHOST_SCATTER, true);
 
-            // Проверяем специальные ограничения для туннелей
-            if (isRestrictedTunnel(currentX, currentY) && newDy == -1) { // Вверх
-                continue;
+                // Устанавливаем длительность scatter-режима
+                if (scatterChaseCycles[i] < 2) {
+                    modeTimers[i] = 7 * 60; // 7 секунд
+                }
+                else {
+                    modeTimers[i] = 5 * 60; // 5 секунд
+                }
             }
 
-            // Проверяем возможность движения
-            int testX = currentX + newDx;
-            int testY = currentY + newDy;
+            setFlag(i, GHOST_MODE_CHANGED, true);
+        }
+    }
 
-            if (map.canMove(testX, testY)) {
-                // Вычисляем расстояние по прямой до цели
-                float distance = std::sqrt(std::pow(target.first - testX, 2) +
-                    std::pow(target.second - testY, 2));
-                validDirections.push_back({ newDx, newDy });
-                distances.push_back(distance);
-            }
+    // Режимы и таймеры как у нового призрака
+    void resetMode(size_t i) {
+        setDirection(i, 0, 0);
+        set<HASH_FLAGS>(flags, i, GHOST_SCATTER);
+        modeTimers[i] = 7 * 60;
+        frightenedTimers[i] = 0;
+        set<HASH_CYCLE>(scatterChaseCycles, i, 0);
+    }
+
+public:
+    // Ближайший к цели выход из клетки (tileX, tileY) среди битов exits:
+    // номер в MAZE_DIRECTIONS или -1, если выходов нет. Квадрат
+    // расстояния от соседа до цели - |offset|^2 + 1 - 2 * (offset, dir),
+    // так что ближе тот сосед, на чьё направление проекция offset больше.
+    // Ключ выхода - проекция с обратным знаком и сдвигом и номер
+    // направления в младших битах, поэтому минимум ключей без ветвлений и
+    // умножений даёт и ближайший выход, и приоритет при равных
+    // расстояниях (вверх, влево, вниз, вправо).
+    static int closestExit(uint8_t exits, int tileX, int tileY, int targetX, int targetY) {
+        const int64_t bias = INT64_C(1) << 34; // больше любой |проекции|
+        int64_t offsetX = static_cast<int64_t>(targetX) - tileX, offsetY = static_cast<int64_t>(targetY) - tileY;
+        uint64_t best = UINT64_MAX;
+        for (int d = 0; d < 4; d++) {
+            int64_t projection = offsetX * MAZE_DIRECTIONS[d][0] + offsetY * MAZE_DIRECTIONS[d][1];
+            uint64_t key = static_cast<uint64_t>(bias - projection) << 2 | static_cast<uint64_t>(d);
+            best = std::min(best, ((exits >> d) & 1) ? key : UINT64_MAX);
         }
+        return best == UINT64_MAX ? -1 : static_cast<int>(best & 3);
+    }
 
-        if (!validDirections.empty()) {
-            // Находим минимальное расстояние
-            float minDistance = *std::min_element(distances.begin(), distances.end());
+    // Выходы, среди которых призрак выбирает путь: без разворота (номер
+    // reverse, -1 - разворота нет) и без поворота вверх при noUpTurn
+    static uint8_t forwardExits(uint8_t exits, int reverse, bool noUpTurn) {
+        if (reverse >= 0) exits &= static_cast<uint8_t>(~(1 << reverse));
+        if (noUpTurn) exits &= static_cast<uint8_t>(~1); // бит 0 - вверх
+        return exits;
+    }
 
-            // Выбираем первое направление с минимальным расстоянием (учитывая приоритет)
-            for (size_t i = 0; i < validDirections.size(); ++i) {
-                if (distances[i] == minDistance) {
-                    dx = validDirections[i].first;
-                    dy = validDirections[i].second;
-                    break;
-                }
-            }
+    // Выбор направления к цели в центре клетки (tileX, tileY).
+    // Без выделений памяти: направления берутся из таблицы MAZE_DIRECTIONS,
+    // проходимость - из маски выходов клетки.
+    // Расстояния сравниваются в квадрате: для целых координат порядок
+    // квадратов совпадает с порядком sqrt, а при равенстве побеждает
+    // направление с большим приоритетом (вверх, влево, вниз, вправо).
+    // Разворот запрещён, пока есть другой путь; noUpTurn запрещает поворот вверх.
+    static void steerToTarget(const GameMap& map, int tileX, int tileY, int targetX, int targetY,
+        bool noUpTurn, int& dx, int& dy) {
+        uint8_t exits = forwardExits(map.exitMask(tileX, tileY), directionIndex(-dx, -dy), noUpTurn);
+        int d = closestExit(exits, tileX, tileY, targetX, targetY);
+        if (d >= 0) {
+            dx = MAZE_DIRECTIONS[d][0];
+            dy = MAZE_DIRECTIONS[d][1];
         }
-        else {
+        else if (map.canStep(tileX, tileY, -dx, -dy)) {
             // Если нет других путей, пробуем идти назад
-            if (map.canMove(currentX - dx, currentY - dy)) {
-                dx = -dx;
-                dy = -dy;
-            }
+            dx = -dx;
+            dy = -dy;
         }
     }
 
-    void chooseRandomDirection(const GameMap& map) {
-        if (!isAtIntersection()) {
-            return;
+    // Случайное доступное направление (режим испуга, ограничения туннелей не действуют)
+    static void steerRandomly(const GameMap& map, int tileX, int tileY, Random& rng, int& dx, int& dy) {
+        int valid[4];
+        int count = 0;
+        uint8_t exits = map.exitMask(tileX, tileY);
+        for (int d = 0; d < 4; d++) {
+            if ((exits >> d) & 1) {
+                valid[count++] = d;
+            }
         }
 
-        alignToGrid();
-
-        std::vector<std::pair<int, int>> validDirections;
-        std::vector<std::pair<int, int>> directions = {
-            {0, -1}, {-1, 0}, {0, 1}, {1, 0} // С приоритетами
-        };
-
-        int currentX = getCurrentTileX();
-        int currentY = getCurrentTileY();
+        if (count > 0) {
+            int d = valid[rng.nextBelow(static_cast<uint32_t>(count))];
+            dx = MAZE_DIRECTIONS[d][0];
+            dy = MAZE_DIRECTIONS[d][1];
+        }
+    }
 
-        for (const auto& dir : directions) {
-            int testX = currentX + dir.first;
-            int testY = currentY + dir.second;
+    size_t size() const { return colors.size(); }
+
+    void reserve(size_t count) {
+        positions.reserve(count);
+        speeds.reserve(count);
+        dxs.reserve(count);
+        dys.reserve(count);
+        respawnXs.reserve(count);
+        respawnYs.reserve(count);
+        frightenedTimers.reserve(count);
+        modeTimers.reserve(count);
+        scatterChaseCycles.reserve(count);
+        colors.reserve(count);
+        flags.reserve(count);
+        rowHashes.reserve(count);
+    }
 
-            if (map.canMove(testX, testY)) {
-                // В режиме испуга игнорируем ограничения туннелей
-                validDirections.push_back(dir);
-            }
-        }
+    // clear() сохраняет ёмкость массивов
+    void clear() {
+        positions.clear();
+        speeds.clear();
+        dxs.clear();
+        dys.clear();
+        respawnXs.clear();
+        respawnYs.clear();
+        frightenedTimers.clear();
+        modeTimers.clear();
+        scatterChaseCycles.clear();
+        colors.clear();
+        flags.clear();
+        rowHashes.clear();
+    }
 
-        if (!validDirections.empty()) {
-            auto randomDir = validDirections[rand() % validDirections.size()];
-            dx = randomDir.first;
-            dy = randomDir.second;
-        }
+    // Новый призрак в конец таблицы; стартовая клетка (startX, startY),
+    // появляется он на три клетки ниже по y
+    void add(int startX, int startY, GhostColor color) {
+        int x = fixedFromTile(startX);
+        int y = fixedFromTile(startY - 3);
+        positions.add(x, y);
+        speeds.push_back(FIXED_ONE * 8 / 100);
+        dxs.push_back(0);
+        dys.push_back(0);
+        respawnXs.push_back(x);
+        respawnYs.push_back(y);
+        frightenedTimers.push_back(0);
+        modeTimers.push_back(7 * 60);
+        scatterChaseCycles.push_back(0);
+        colors.push_back(static_cast<uint8_t>(color));
+        flags.push_back(GHOST_SCATTER);
+        rowHashes.push_back(0);
+        rowHashes.back() = rowHash(rowHashes.size() - 1);
     }
 
-    void updateMode() {
-        if (vulnerable) {
-            frightenedTimer--;
-            if (frightenedTimer <= 0) {
-                vulnerable = false;
-                // При выходе из frightened НЕ разворачиваемся
+    void update(size_t i, const GameMap& map, const Pacman& pacman, Random& rng) {
+        updateMode(i);
+        chooseBestDirection(i, map, pacman, rng);
+
+        // Движение. Шаг обрезается по следующему центру клетки, чтобы
+        // призрак остановился ровно в нём и принял решение.
+        int dx = dxs[i], dy = dys[i];
+        if (dx != 0 || dy != 0) {
+            int x = positions.getX(i), y = positions.getY(i);
+            int speed = speeds[i];
+            int newX = x + dx * speed;
+            int newY = y + dy * speed;
+            if (dx > 0) newX = std::min(newX, fixedNextCenter(x, 1));
+            else if (dx < 0) newX = std::max(newX, fixedNextCenter(x, -1));
+            if (dy > 0) newY = std::min(newY, fixedNextCenter(y, 1));
+            else if (dy < 0) newY = std::max(newY, fixedNextCenter(y, -1));
+
+            if (map.canEnter(fixedTruncToTile(newX), fixedTruncToTile(newY))) {
+                positions.set(i, newX, newY);
+            }
+            else {
+                alignToGrid(i);
+                setDirection(i, 0, 0);
             }
         }
+    }
 
-        // Обновляем таймер режима
-        modeTimer--;
+    // Через сколько тиков update() сделает что-то кроме равномерного
+    // движения к следующему центру и счёта таймеров: решение в центре
+    // клетки, упор в стену, конец режима или испуга
+    int ticksToNextEvent(size_t i, const GameMap& map) const {
+        if (isAtIntersection(i)) return 1;
 
-        // Волны scatter/chase согласно оригинальной механике
-        if (modeTimer <= 0) {
-            if (inScatterMode) {
-                // Завершился scatter-режим, переходим в chase
-                inScatterMode = false;
-                scatterChaseCycle++;
+        int ticks = NO_EVENT;
+        if (hasFlag(i, GHOST_VULNERABLE)) ticks = std::max(1, static_cast<int>(frightenedTimers[i]));
+        ticks = std::min(ticks, std::max(1, static_cast<int>(modeTimers[i])));
 
-                // Устанавливаем длительность chase-режима
-                if (scatterChaseCycle < 4) {
-                    modeTimer = 20 * 60; // 20 секунд (60 FPS)
-                }
-                else {
-                    modeTimer = -1; // Бесконечный chase
-                }
+        int dx = dxs[i], dy = dys[i];
+        if (dx != 0 || dy != 0) {
+            int x = positions.getX(i), y = positions.getY(i);
+            int speed = speeds[i];
+            int centerX = dx != 0 ? fixedNextCenter(x, dx) : x;
+            int centerY = dy != 0 ? fixedNextCenter(y, dy) : y;
+            int distance = std::abs(centerX - x) + std::abs(centerY - y);
+            int arrival = (distance + speed - 1) / speed;
+            // До центра клетка по усечению не меняется, поэтому стены
+            // проверяются дважды: для шагов до центра и для шага в центр.
+            // Следующий тик после прихода - решение в центре.
+            if (arrival > 1 && !map.canEnter(fixedTruncToTile(x + dx * speed), fixedTruncToTile(y + dy * speed))) {
+                ticks = 1;
+            }
+            else if (!map.canEnter(fixedTruncToTile(centerX), fixedTruncToTile(centerY))) {
+                ticks = std::min(ticks, arrival);
             }
             else {
-                // Завершился chase-режим, переходим в scatter
-                inScatterMode = true;
-
-                // Устанавливаем длительность scatter-режима
-                if (scatterChaseCycle < 2) {
-                    modeTimer = 7 * 60; // 7 секунд
-                }
-                else {
-                    modeTimer = 5 * 60; // 5 секунд
-                }
+                ticks = std::min(ticks, arrival + 1);
             }
-
-            modeJustChanged = true;
         }
+        return ticks;
     }
 
-public:
-    Ghost(float startX, float startY, GhostColor ghostColor)
-        : x(startX), y(startY - 3), speed(0.08f), dx(0), dy(0),
-        vulnerable(false), respawnX(startX), respawnY(startY - 3),
-        color(ghostColor), frightenedTimer(0), modeTimer(7 * 60),
-        inScatterMode(true), scatterChaseCycle(0), modeJustChanged(false) {
+    // Призрак на линии центров клеток и едет вдоль неё, поэтому без
+    // рывков с линий центров не сойдёт (в центре поворачивает на другую)
+    bool staysOnGridLines(size_t i) const {
+        bool centeredX = fixedIsCentered(positions.getX(i)), centeredY = fixedIsCentered(positions.getY(i));
+        if (dxs[i] != 0) return dys[i] == 0 && centeredY;
+        if (dys[i] != 0) return centeredX;
+        return centeredX || centeredY;
     }
 
-    void update(const GameMap& map, const Pacman& pacman) {
-        updateMode();
-        chooseBestDirection(map, pacman);
+    // ticks вызовов updateMode() для призрака без испуга: таймер режима
+    // разом, смены режима - настоящим кодом
+    void advanceMode(size_t i, int ticks) {
+        for (;;) {
+            int untilSwitch = std::max(1, static_cast<int>(modeTimers[i]));
+            if (untilSwitch > ticks) {
+                modeTimers[i] -= ticks;
+                return;
+            }
+            ticks -= untilSwitch;
+            modeTimers[i] = 1;
+            updateMode(i);
+        }
+    }
 
-        // Движение
-        float newX = x + dx * speed;
-        float newY = y + dy * speed;
+    // Переходы от центра клетки к центру разом: тик решения и тики
+    // движения до следующего центра. Только без испуга (решение без
+    // генератора) и пока Пакман все эти тики неподвижен; призрак стоит в
+    // центре перед своим тиком решения. Решение - выбор выхода к цели или
+    // разворот после смены режима, смены режима по дороге - advanceMode.
+    // Переход, на котором призрак может подойти к Пакману ближе
+    // contactRadius, не делается: на прогоне касаний нет.
+    // Выполняет не больше ticks тиков (последний переход может оборваться
+    // на середине) и возвращает, через сколько тиков от начала следующее
+    // событие призрака; 0 - первое решение не такое, его делает update().
+    int runBetweenCenters(size_t i, int ticks, const GameMap& map, const Pacman& pacman, int contactRadius) {
+        int speed = speeds[i];
+        if (speed <= 0 || ticks <= 0 || hasFlag(i, GHOST_VULNERABLE) || !isAtIntersection(i)) return 0;
+        int tileTicks = (FIXED_ONE + speed - 1) / speed;
+        int tileX = getCurrentTileX(i), tileY = getCurrentTileY(i);
+        if (!map.canEnter(tileX, tileY)) return 0;
+
+        // Направление - номер в MAZE_DIRECTIONS (-1 - стоит). Цель от пути
+        // призрака зависит только у Inky и Clyde, у остальных она
+        // пересчитывается лишь при смене режима.
+        int d = directionIndex(dxs[i], dys[i]);
+        if (d < 0 && (dxs[i] != 0 || dys[i] != 0)) return 0;
+        bool movingTarget = colors[i] == CYAN || colors[i] == ORANGE;
+        uint8_t targetFlags = static_cast<uint8_t>(~flags[i]);
+        std::pair<int, int> target;
+        int pacmanX = pacman.getFixedX(), pacmanY = pacman.getFixedY();
+        int64_t contactSquared = static_cast<int64_t>(contactRadius) * contactRadius;
+        int contactReach = FIXED_ONE + contactRadius;
+        // Позиция и таймер режима - в локальных, в таблицу пишутся, только
+        // когда их кто-то читает
+        int x = fixedFromTile(tileX), y = fixedFromTile(tileY);
+        int timer = modeTimers[i];
+        int span = 0, done = 0;
+        // Пока режим не сменился, переход зависит только от клетки,
+        // направления и флагов призрака. Вернувшись в то же состояние,
+        // призрак ходит по кругу, и целые круги проходятся разом. Состояние
+        // для сравнения запоминается на 1, 2, 4, 8... переходе (как в
+        // алгоритме Брента), смена режима его сбрасывает.
+        int markX = tileX, markY = tileY, markD = d, markSpan = 0;
+        uint8_t markFlags = flags[i];
+        int steps = 0, nextMark = 1;
+        // Смена режима на самом тике решения меняет и решение - это update()
+        while (span < ticks && timer > 1) {
+            if (span > markSpan && tileX == markX && tileY == markY && d == markD && flags[i] == markFlags) {
+                int period = span - markSpan;
+                int laps = std::min((ticks - span) / period, (timer - 1) / period);
+                span += laps * period;
+                done += laps * period;
+                timer -= laps * period;
+                if (span >= ticks || timer <= 1) break;
+            }
+            if (++steps == nextMark) {
+                markX = tileX;
+                markY = tileY;
+                markD = d;
+                markFlags = flags[i];
+                markSpan = span;
+                nextMark *= 2;
+            }
+            uint8_t exits = map.exitMask(tileX, tileY);
+            int reverse = d >= 0 ? (d + 2) & 3 : -1;
+            int next = reverse;
+            bool turnBack = hasFlag(i, GHOST_MODE_CHANGED);
+            if (!turnBack) {
+                uint8_t forward = forwardExits(exits, reverse, isRestrictedTunnel(tileX, tileY));
+                if (forward & (forward - 1)) {
+                    if (movingTarget || targetFlags != flags[i]) {
+                        targetFlags = flags[i];
+                        positions.set(i, x, y);
+                        target = hasFlag(i, GHOST_SCATTER) ? getScatterTarget(i) : getChaseTarget(i, pacman);
+                    }
+                    next = closestExit(forward, tileX, tileY, target.first, target.second);
+                }
+                // В коридоре выбирать не из чего, цель не нужна; нет
+                // других путей - назад
+                else if (forward != 0) next = (forward & 1) ? 0 : (forward & 2) ? 1 : (forward & 4) ? 2 : 3;
+            }
 
-        if (dx != 0 || dy != 0) {
-            if (map.canMove(newX, newY)) {
-                x = newX;
-                y = newY;
+            // Переход без упоров: выход есть, а координаты на пути не
+            // отрицательны (усечение совпадает с floor)
+            if (next < 0 || !((exits >> next) & 1) ||
+                tileX + MAZE_DIRECTIONS[next][0] < 0 || tileY + MAZE_DIRECTIONS[next][1] < 0) {
+                break;
             }
+            // и без касания: ближайшая к Пакману точка отрезка между центрами
+            // (отрезок не длиннее клетки, дальние клетки сразу мимо)
+            int fromX = fixedFromTile(tileX), fromY = fixedFromTile(tileY);
+            if (std::abs(fromX - pacmanX) < contactReach && std::abs(fromY - pacmanY) < contactReach) {
+                int toX = fromX + MAZE_DIRECTIONS[next][0] * FIXED_ONE, toY = fromY + MAZE_DIRECTIONS[next][1] * FIXED_ONE;
+                int nearX = std::min(std::max(pacmanX, std::min(fromX, toX)), std::max(fromX, toX));
+                int nearY = std::min(std::max(pacmanY, std::min(fromY, toY)), std::max(fromY, toY));
+                if (fixedDistanceSquared(nearX, nearY, pacmanX, pacmanY) < contactSquared) break;
+            }
+            if (turnBack) setFlag(i, GHOST_MODE_CHANGED, false);
+            d = next;
+            int moved = std::min(tileTicks, ticks - span);
+            int step = std::min(moved * speed, FIXED_ONE);
+            x = fromX + MAZE_DIRECTIONS[d][0] * step;
+            y = fromY + MAZE_DIRECTIONS[d][1] * step;
+            if (timer > moved) timer -= moved;
             else {
-                alignToGrid();
-                dx = 0;
-                dy = 0;
+                modeTimers[i] = timer;
+                advanceMode(i, moved);
+                timer = modeTimers[i];
+                markSpan = INT32_MAX;
             }
+            tileX += MAZE_DIRECTIONS[d][0];
+            tileY += MAZE_DIRECTIONS[d][1];
+            span += tileTicks;
+            done += moved;
+        }
+        if (span == 0) return 0;
+        positions.set(i, x, y);
+        modeTimers[i] = timer;
+        setDirection(i, MAZE_DIRECTIONS[d][0], MAZE_DIRECTIONS[d][1]);
+        // Оборванный переход: режим может смениться раньше центра
+        return std::min(span, done - 1 + std::max(1, timer));
+    }
+
+    // ticks вызовов update() разом; только для ticks < ticksToNextEvent()
+    void coast(size_t i, int ticks) {
+        if (hasFlag(i, GHOST_VULNERABLE)) frightenedTimers[i] -= ticks;
+        modeTimers[i] -= ticks;
+        int speed = speeds[i];
+        if (dxs[i] != 0) {
+            int x = positions.getX(i);
+            positions.setX(i, dxs[i] > 0 ? std::min(x + speed * ticks, fixedNextCenter(x, 1))
+                                         : std::max(x - speed * ticks, fixedNextCenter(x, -1)));
+        }
+        else if (dys[i] != 0) {
+            int y = positions.getY(i);
+            positions.setY(i, dys[i] > 0 ? std::min(y + speed * ticks, fixedNextCenter(y, 1))
+                                         : std::max(y - speed * ticks, fixedNextCenter(y, -1)));
         }
     }
 
-    void setVulnerable(bool isVulnerable) {
+    void setVulnerable(size_t i, bool isVulnerable) {
+        bool vulnerable = hasFlag(i, GHOST_VULNERABLE);
         if (isVulnerable && !vulnerable) {
-            vulnerable = true;
-            frightenedTimer = 6 * 60;
+            setFlag(i, GHOST_VULNERABLE, true);
+            frightenedTimers[i] = 6 * 60;
             // При входе в frightened разворачиваемся
-            dx = -dx;
-            dy = -dy;
+            setDirection(i, -dxs[i], -dys[i]);
         }
         else if (!isVulnerable && vulnerable) {
-            vulnerable = false;
-            frightenedTimer = 0;
+            setFlag(i, GHOST_VULNERABLE, false);
+            frightenedTimers[i] = 0;
             // При выходе из frightened НЕ разворачиваемся
         }
     }
 
-    bool isVulnerable() const { return vulnerable; }
-    GhostColor getColor() const { return color; }
-    float getX() const { return x; }
-    float getY() const { return y; }
-    int getDirectionX() const { return dx; }
-    int getDirectionY() const { return dy; }
-
-    void respawn(int mapWidth, int mapHeight) {
-        x = respawnX;
-        y = respawnY;
-        dx = 0;
-        dy = 0;
-        vulnerable = false;
-        inScatterMode = true;
-        modeTimer = 7 * 60;
-        frightenedTimer = 0;
-        scatterChaseCycle = 0;
-        modeJustChanged = false;
-        alignToGrid();
-    }
-
-    void resetPosition(float newX, float newY) {
-        x = newX;
-        y = newY - 3;
-        dx = 0;
-        dy = 0;
-        vulnerable = false;
-        inScatterMode = true;
-        modeTimer = 7 * 60;
-        frightenedTimer = 0;
-        scatterChaseCycle = 0;
-        modeJustChanged = false;
-    }
-
-    void setSpeed(float newSpeed) { speed = newSpeed; }
+    // Обратно в точку появления
+    void respawn(size_t i) {
+        positions.set(i, respawnXs[i], respawnYs[i]);
+        resetMode(i);
+        alignToGrid(i);
+    }
+
+    // Позиция в единицах FIXED_ONE; y, как и в add, на три клетки ниже
+    void resetPosition(size_t i, int newX, int newY) {
+        positions.set(i, newX, newY - fixedFromTile(3));
+        resetMode(i);
+    }
+
+    void setSpeed(size_t i, int newSpeed) { set<HASH_SPEED>(speeds, i, newSpeed); }
+
+    // Хеш всех полей всех призраков для Game::stateHash(): к сумме редких
+    // полей призрака добавляются позиция и таймеры прямо из массивов (по
+    // два поля на умножение), призраки сворачиваются по Горнеру - у
+    // каждого свой множитель rowKey^k. Умножение в цепочке заодно не даёт
+    // векторизовать цикл: 64-битное умножение в SSE2 эмулируется и
+    // выходит в разы дороже.
+    uint64_t getHashSum() const {
+        constexpr uint64_t keyPosition = stateFieldKey(STATE_KEYS_GHOSTS + HASH_POSITION);
+        constexpr uint64_t keyTimers = stateFieldKey(STATE_KEYS_GHOSTS + HASH_TIMERS);
+        constexpr uint64_t rowKey = stateFieldKey(STATE_KEYS_GHOSTS + HASH_FIELD_COUNT);
+        uint64_t sum = 0;
+        for (size_t i = 0; i < rowHashes.size(); i++) {
+            sum = sum * rowKey + rowHashes[i] +
+                keyPosition * stateHashPair(positions.getX(i), positions.getY(i)) +
+                keyTimers * stateHashPair(frightenedTimers[i], modeTimers[i]);
+        }
+        return sum;
+    }
+
+    const GhostPositions& getPositions() const { return positions; }
+    bool isVulnerable(size_t i) const { return hasFlag(i, GHOST_VULNERABLE); }
+    GhostColor getColor(size_t i) const { return static_cast<GhostColor>(colors[i]); }
+    int getFixedX(size_t i) const { return positions.getX(i); }
+    int getFixedY(size_t i) const { return positions.getY(i); }
+    int getFixedSpeed(size_t i) const { return speeds[i]; }
+    int getDirectionX(size_t i) const { return dxs[i]; }
+    int getDirectionY(size_t i) const { return dys[i]; }
+
+    void saveState(size_t i, GhostState& out) const {
+        out.x = positions.getX(i);
+        out.y = positions.getY(i);
+        out.speed = speeds[i];
+        out.dx = dxs[i];
+        out.dy = dys[i];
+        out.respawnX = respawnXs[i];
+        out.respawnY = respawnYs[i];
+        out.frightenedTimer = frightenedTimers[i];
+        out.modeTimer = modeTimers[i];
+        out.scatterChaseCycle = scatterChaseCycles[i];
+        out.color = colors[i];
+        out.vulnerable = hasFlag(i, GHOST_VULNERABLE);
+        out.inScatterMode = hasFlag(i, GHOST_SCATTER);
+        out.modeJustChanged = hasFlag(i, GHOST_MODE_CHANGED);
+    }
+
+    // count одинаковых призраков вместо прежних (для loadState)
+    void assign(size_t count) {
+        clear();
+        for (size_t i = 0; i < count; i++) add(0, 0, RED);
+    }
+
+    void loadState(size_t i, const GhostState& in) {
+        positions.set(i, in.x, in.y);
+        speeds[i] = in.speed;
+        dxs[i] = static_cast<int8_t>(in.dx);
+        dys[i] = static_cast<int8_t>(in.dy);
+        respawnXs[i] = in.respawnX;
+        respawnYs[i] = in.respawnY;
+        frightenedTimers[i] = in.frightenedTimer;
+        modeTimers[i] = in.modeTimer;
+        scatterChaseCycles[i] = in.scatterChaseCycle;
+        colors[i] = in.color;
+        flags[i] = static_cast<uint8_t>((in.vulnerable ? GHOST_VULNERABLE : 0) |
+            (in.inScatterMode ? GHOST_SCATTER : 0) | (in.modeJustChanged ? GHOST_MODE_CHANGED : 0));
+        rowHashes[i] = rowHash(i);
+    }
+
+    // Обход по призракам: элемент - Ghost, вид на строку таблицы
+    class Iterator {
+    private:
+        const GhostTable* table;
+        size_t index;
+
+    public:
+        Iterator(const GhostTable* table, size_t index) : table(table), index(index) {}
+        Ghost operator*() const;
+        Iterator& operator++() {
+            index++;
+            return *this;
+        }
+        bool operator!=(const Iterator& other) const { return index != other.index; }
+    };
+
+    Ghost operator[](size_t i) const;
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, size()); }
 };
 
-#endif
\ No newline at end of file
+// Один призрак таблицы только для чтения - для отрисовки и вывода.
+// Живёт не дольше таблицы и не переживает её изменения размера.
+class Ghost {
+private:
+    const GhostTable* table;
+    size_t index;
+
+public:
+    Ghost(const GhostTable& table, size_t index) : table(&table), index(index) {}
+
+    bool isVulnerable() const { return table->isVulnerable(index); }
+    GhostColor getColor() const { return table->getColor(index); }
+    int getFixedX() const { return table->getFixedX(index); }
+    int getFixedY() const { return table->getFixedY(index); }
+    int getFixedSpeed() const { return table->getFixedSpeed(index); }
+
+    // Позиция в клетках - для отрисовки
+    float getX() const { return fixedToFloat(getFixedX()); }
+    float getY() const { return fixedToFloat(getFixedY()); }
+    int getDirectionX() const { return table->getDirectionX(index); }
+    int getDirectionY() const { return table->getDirectionY(index); }
+};
+
+inline Ghost GhostTable::operator[](size_t i) const { return Ghost(*this, i); }
+inline Ghost GhostTable::Iterator::operator*() const { return Ghost(*table, index); }
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef GHOSTPOSITIONS_H
+#define GHOSTPOSITIONS_H
+
+#include "coinLayer.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#if defined(__AVX__)
+#include <immintrin.h>
+#define GHOST_POSITIONS_AVX 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GHOST_POSITIONS_SSE2 1
+#endif
+
+// Радиус касания, при котором векторная проверка точна (см. firstContact)
+const int MAX_CONTACT_RADIUS = 4095;
+
+// Позиции призраков отдельными массивами x и y (структура массивов):
+// проверка касания читает подряд только координаты, по 8 (AVX) или 4 (SSE2)
+// призрака за шаг. Это столбцы x, y таблицы призраков GhostTable, других
+// копий позиций нет.
+class GhostPositions {
+private:
+    std::vector<int32_t> xs, ys;
+
+public:
+    void resize(size_t count) {
+        xs.resize(count);
+        ys.resize(count);
+    }
+
+    void reserve(size_t count) {
+        xs.reserve(count);
+        ys.reserve(count);
+    }
+
+    void clear() {
+        xs.clear();
+        ys.clear();
+    }
+
+    void add(int x, int y) {
+        xs.push_back(x);
+        ys.push_back(y);
+    }
+
+    size_t size() const { return xs.size(); }
+
+    void set(size_t index, int x, int y) {
+        xs[index] = x;
+        ys[index] = y;
+    }
+
+    void setX(size_t index, int x) { xs[index] = x; }
+    void setY(size_t index, int y) { ys[index] = y; }
+
+    int getX(size_t index) const { return xs[index]; }
+    int getY(size_t index) const { return ys[index]; }
+
+    // Наименьший индекс призрака, чей центр ближе radius к (px, py), или -1 -
+    // как прежний цикл с выходом на первом касании. Векторные ветки считают
+    // в float: квадраты целых меньше 2^24 точны, а всё, что больше,
+    // округляется не ниже 2^24 > radius^2, поэтому при radius <=
+    // MAX_CONTACT_RADIUS ответ тот же, что у целочисленной проверки.
+    int firstContact(int px, int py, int radius) const {
+        const int count = static_cast<int>(xs.size());
+        const int32_t* x = xs.data();
+        const int32_t* y = ys.data();
+        int i = 0;
+
+#ifdef GHOST_POSITIONS_AVX
+        {
+            const __m256 centerX = _mm256_set1_ps(static_cast<float>(px));
+            const __m256 centerY = _mm256_set1_ps(static_cast<float>(py));
+            const __m256 limit = _mm256_set1_ps(static_cast<float>(radius) * static_cast<float>(radius));
+            for (; i + 8 <= count; i += 8) {
+                __m256 dx = _mm256_sub_ps(_mm256_cvtepi32_ps(
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i))), centerX);
+                __m256 dy = _mm256_sub_ps(_mm256_cvtepi32_ps(
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i))), centerY);
+                __m256 squared = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+                int mask = _mm256_movemask_ps(_mm256_cmp_ps(squared, limit, _CMP_LT_OQ));
+                if (mask) return i + countTrailingZeros(static_cast<uint64_t>(mask));
+            }
+        }
+#endif
+#ifdef GHOST_POSITIONS_SSE2
+        {
+            const __m128 centerX = _mm_set1_ps(static_cast<float>(px));
+            const __m128 centerY = _mm_set1_ps(static_cast<float>(py));
+            const __m128 limit = _mm_set1_ps(static_cast<float>(radius) * static_cast<float>(radius));
+            for (; i + 4 <= count; i += 4) {
+                __m128 dx = _mm_sub_ps(_mm_cvtepi32_ps(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i))), centerX);
+                __m128 dy = _mm_sub_ps(_mm_cvtepi32_ps(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i))), centerY);
+                __m128 squared = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+                int mask = _mm_movemask_ps(_mm_cmplt_ps(squared, limit));
+                if (mask) return i + countTrailingZeros(static_cast<uint64_t>(mask));
+            }
+        }
+#endif
+
+        // Хвост и сборки без SIMD: точные 64-битные квадраты
+        const int64_t limit = static_cast<int64_t>(radius) * radius;
+        for (; i < count; i++) {
+            int64_t dx = static_cast<int64_t>(x[i]) - px;
+            int64_t dy = static_cast<int64_t>(y[i]) - py;
+            if (dx * dx + dy * dy < limit) return i;
+        }
+        return -1;
+    }
+};
+
+#endif
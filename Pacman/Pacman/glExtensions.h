@@ -0,0 +1,48 @@
+#ifndef GLEXTENSIONS_H
+#define GLEXTENSIONS_H
+
+// OpenGL вместе с буферами вершин. opengl32 в Windows знает только GL 1.1,
+// остальное загружает GLEW из пакета nupengl; в других системах libGL
+// экспортирует эти функции сама. Подключать вместо <GL/glut.h>.
+#ifdef _WIN32
+#include <GL/glew.h>
+#elif !defined(GL_GLEXT_PROTOTYPES)
+#define GL_GLEXT_PROTOTYPES
+#endif
+#include <GL/glut.h>
+#include <cstdio>
+#include <cstring>
+
+struct GLCapabilities {
+    bool vertexBuffers; // VBO/IBO: GL 1.5
+    bool vertexArrays;  // VAO: GL 3.0 или ARB_vertex_array_object
+    bool instancing;    // glDrawElementsInstanced + glVertexAttribDivisor и шейдеры: GL 3.3
+};
+
+inline GLCapabilities& glCapabilities() {
+    static GLCapabilities capabilities = { false, false, false };
+    return capabilities;
+}
+
+// Вызывается один раз после glutCreateWindow, когда контекст уже есть
+inline const GLCapabilities& initGLExtensions() {
+    GLCapabilities& capabilities = glCapabilities();
+#ifdef _WIN32
+    if (glewInit() != GLEW_OK) return capabilities;
+    capabilities.vertexBuffers = GLEW_VERSION_1_5 != 0;
+    capabilities.vertexArrays = GLEW_VERSION_3_0 || GLEW_ARB_vertex_array_object;
+    capabilities.instancing = GLEW_VERSION_3_3 != 0;
+#else
+    int major = 0, minor = 0;
+    const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    if (version) std::sscanf(version, "%d.%d", &major, &minor);
+    const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+    capabilities.vertexBuffers = major > 1 || (major == 1 && minor >= 5);
+    capabilities.vertexArrays = major >= 3 ||
+        (extensions && std::strstr(extensions, "GL_ARB_vertex_array_object") != nullptr);
+    capabilities.instancing = major > 3 || (major == 3 && minor >= 3);
+#endif
+    return capabilities;
+}
+
+#endif
@@ -0,0 +1,245 @@
+#ifndef GLSTATECACHE_H
+#define GLSTATECACHE_H
+
+#include "glExtensions.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+// Сколько вложенных pushMaterial помнит кэш (в сцене их не больше двух)
+const int GL_STATE_STACK_DEPTH = 8;
+
+// Флаги glEnable, которые ведёт кэш; остальные идут в OpenGL напрямую
+const GLenum GL_STATE_CAPS[] = { GL_LIGHTING, GL_LIGHT0, GL_LIGHT1, GL_DEPTH_TEST, GL_NORMALIZE };
+const int GL_STATE_CAP_COUNT = sizeof(GL_STATE_CAPS) / sizeof(GL_STATE_CAPS[0]);
+const int GL_STATE_LIGHTS = 2; // GL_LIGHT0, GL_LIGHT1
+
+// Вызовы за кадр: сколько ушло в OpenGL, сколько пропущено как повторные
+// и сколько чтений glGet не понадобилось (их раньше делал MaterialSaver)
+struct GLStateCounts {
+    uint64_t issued;
+    uint64_t skipped;
+    uint64_t readsAvoided;
+};
+
+// Материал целиком: поля, которые glMaterialfv ставит по отдельности
+struct GLMaterial {
+    GLfloat ambient[4];
+    GLfloat diffuse[4];
+    GLfloat specular[4];
+    GLfloat shininess;
+};
+
+// Копия состояния OpenGL на CPU: материал (лицевой и обратной стороны),
+// цвета источников света и флаги glEnable. Вызов, который ничего не
+// меняет, не доходит до драйвера, а сохранение материала - копия в стек
+// вместо четырёх glGetMaterialfv, каждый из которых на многих драйверах
+// ждёт конвейер. Работает, пока это состояние меняется только через кэш;
+// после чужих вызовов - reset().
+class GLStateCache {
+private:
+    struct LightColors {
+        GLfloat ambient[4];
+        GLfloat diffuse[4];
+        GLfloat specular[4];
+    };
+
+    GLMaterial materials[2]; // 0 - GL_FRONT, 1 - GL_BACK
+    LightColors lights[GL_STATE_LIGHTS];
+    bool caps[GL_STATE_CAP_COUNT];
+    GLMaterial stack[GL_STATE_STACK_DEPTH][2];
+    int depth;
+    GLStateCounts counts;
+
+    static bool same(const GLfloat* a, const GLfloat* b, int n) {
+        return std::memcmp(a, b, n * sizeof(GLfloat)) == 0;
+    }
+
+    static int capIndex(GLenum cap) {
+        for (int i = 0; i < GL_STATE_CAP_COUNT; i++) {
+            if (GL_STATE_CAPS[i] == cap) return i;
+        }
+        return -1;
+    }
+
+    // Поле материала по pname; nullptr - кэш его не ведёт
+    static GLfloat* materialField(GLMaterial& material, GLenum pname, int& size) {
+        switch (pname) {
+        case GL_AMBIENT: size = 4; return material.ambient;
+        case GL_DIFFUSE: size = 4; return material.diffuse;
+        case GL_SPECULAR: size = 4; return material.specular;
+        case GL_SHININESS: size = 1; return &material.shininess;
+        default: return nullptr;
+        }
+    }
+
+    static GLfloat* lightField(LightColors& light, GLenum pname) {
+        switch (pname) {
+        case GL_AMBIENT: return light.ambient;
+        case GL_DIFFUSE: return light.diffuse;
+        case GL_SPECULAR: return light.specular;
+        default: return nullptr;
+        }
+    }
+
+    static void setColor(GLfloat* target, GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+        target[0] = r; target[1] = g; target[2] = b; target[3] = a;
+    }
+
+public:
+    GLStateCache() : depth(0) {
+        reset();
+        counts = GLStateCounts();
+    }
+
+    // Состояние нового контекста по спецификации OpenGL. Вызывается, когда
+    // контекст только создан, или чтобы забыть всё, что было выставлено мимо кэша
+    // (тогда сразу за reset кэш должен сам выставить нужное).
+    void reset() {
+        for (GLMaterial& material : materials) {
+            setColor(material.ambient, 0.2f, 0.2f, 0.2f, 1.0f);
+            setColor(material.diffuse, 0.8f, 0.8f, 0.8f, 1.0f);
+            setColor(material.specular, 0.0f, 0.0f, 0.0f, 1.0f);
+            material.shininess = 0.0f;
+        }
+        for (int i = 0; i < GL_STATE_LIGHTS; i++) {
+            GLfloat value = i == 0 ? 1.0f : 0.0f;
+            setColor(lights[i].ambient, 0.0f, 0.0f, 0.0f, 1.0f);
+            setColor(lights[i].diffuse, value, value, value, 1.0f);
+            setColor(lights[i].specular, value, value, value, 1.0f);
+        }
+        for (bool& cap : caps) cap = false;
+        depth = 0;
+    }
+
+    void setEnabled(GLenum cap, bool enabled) {
+        int i = capIndex(cap);
+        if (i >= 0 && caps[i] == enabled) {
+            counts.skipped++;
+            return;
+        }
+        if (i >= 0) caps[i] = enabled;
+        if (enabled) glEnable(cap);
+        else glDisable(cap);
+        counts.issued++;
+    }
+
+    void enable(GLenum cap) { setEnabled(cap, true); }
+    void disable(GLenum cap) { setEnabled(cap, false); }
+
+    // glMaterialfv; GL_FRONT_AND_BACK пропускается, только если совпали обе стороны
+    void material(GLenum face, GLenum pname, const GLfloat* params) {
+        int first = face == GL_BACK ? 1 : 0;
+        int last = face == GL_FRONT ? 0 : 1;
+        int size = 0;
+        bool redundant = true;
+        for (int f = first; f <= last; f++) {
+            GLfloat* field = materialField(materials[f], pname, size);
+            if (!field) {
+                redundant = false;
+                break;
+            }
+            if (!same(field, params, size)) {
+                redundant = false;
+                std::memcpy(field, params, size * sizeof(GLfloat));
+            }
+        }
+        if (redundant) {
+            counts.skipped++;
+            return;
+        }
+        glMaterialfv(face, pname, params);
+        counts.issued++;
+    }
+
+    void material(GLenum face, GLenum pname, GLfloat param) {
+        material(face, pname, &param);
+    }
+
+    // Все четыре поля сразу; в OpenGL уходят только отличающиеся от текущих
+    void material(GLenum face, const GLMaterial& value) {
+        material(face, GL_AMBIENT, value.ambient);
+        material(face, GL_DIFFUSE, value.diffuse);
+        material(face, GL_SPECULAR, value.specular);
+        material(face, GL_SHININESS, value.shininess);
+    }
+
+    // Цвета источника кэшируются; положение уходит всегда - OpenGL умножает
+    // его на текущую матрицу вида, одинаковые числа ещё не значат одинаковый свет
+    void light(GLenum lightId, GLenum pname, const GLfloat* params) {
+        int index = static_cast<int>(lightId) - GL_LIGHT0;
+        GLfloat* field = index >= 0 && index < GL_STATE_LIGHTS ? lightField(lights[index], pname) : nullptr;
+        if (field) {
+            if (same(field, params, 4)) {
+                counts.skipped++;
+                return;
+            }
+            std::memcpy(field, params, 4 * sizeof(GLfloat));
+        }
+        glLightfv(lightId, pname, params);
+        counts.issued++;
+    }
+
+    // Сохранение материала обеих сторон: копия в стек без обращения к OpenGL
+    void pushMaterial() {
+        if (depth < GL_STATE_STACK_DEPTH) {
+            stack[depth][0] = materials[0];
+            stack[depth][1] = materials[1];
+        }
+        depth++;
+        counts.readsAvoided += 4;
+    }
+
+    // Восстановление: в OpenGL уходят только поля, которые успели измениться.
+    // Пропуски считаются по лицевой стороне - её восстанавливал MaterialSaver;
+    // обратная восстанавливается, только если её кто-то менял.
+    void popMaterial() {
+        if (depth == 0) return;
+        depth--;
+        if (depth >= GL_STATE_STACK_DEPTH) return;
+        static const GLenum fields[] = { GL_AMBIENT, GL_DIFFUSE, GL_SPECULAR, GL_SHININESS };
+        for (GLenum pname : fields) {
+            int size = 0;
+            material(GL_FRONT, pname, materialField(stack[depth][0], pname, size));
+            const GLfloat* saved = materialField(stack[depth][1], pname, size);
+            if (!same(materialField(materials[1], pname, size), saved, size)) material(GL_BACK, pname, saved);
+        }
+    }
+
+    // Счётчики с начала кадра
+    GLStateCounts frameCounts() const { return counts; }
+    void beginFrame() { counts = GLStateCounts(); }
+};
+
+inline GLStateCache& glState() {
+    static GLStateCache cache;
+    return cache;
+}
+
+// Сводка по кадрам для --gl-stats
+struct GLStateStats {
+    uint64_t frames;
+    GLStateCounts total;
+    uint64_t maxIssued;
+
+    GLStateStats() : frames(0), total(), maxIssued(0) {}
+
+    void add(const GLStateCounts& frame) {
+        frames++;
+        total.issued += frame.issued;
+        total.skipped += frame.skipped;
+        total.readsAvoided += frame.readsAvoided;
+        maxIssued = std::max(maxIssued, frame.issued);
+    }
+
+    void print(FILE* out) const {
+        double n = frames > 0 ? static_cast<double>(frames) : 1.0;
+        std::fprintf(out, "GL state: %llu frames; per frame %.1f calls issued (max %llu), "
+            "%.1f redundant skipped, %.1f glGet reads avoided\n",
+            static_cast<unsigned long long>(frames), total.issued / n,
+            static_cast<unsigned long long>(maxIssued), total.skipped / n, total.readsAvoided / n);
+    }
+};
+
+#endif
@@ -1,13 +1,24 @@
 #define _CRT_SECURE_NO_WARNINGS
 
-#include <GL/glut.h>
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
-#include <assimp/mesh.h>
+#include "glExtensions.h"
+#include <algorithm>
 #include <iostream>
 #include <cmath>
+#include <ctime>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
 #include "game.h"
+#include "fixedTimestep.h"
+#include "replay.h"
+#include "profiler.h"
+#include "allocationHooks.h"
+#include "pelletRenderer.h"
+#include "glStateCache.h"
+#include "renderQueue.h"
+#include "wallMesh.h"
+#include "model3DS.h"
 #include <fstream>
 #include <sstream>
 #include <vector>
@@ -18,171 +29,47 @@
 #define M_PI 3.14159265358979323846
 #endif
 
-// Вспомогательные функции для работы с матрицами
-aiMatrix4x4 multiplyMatrices(const aiMatrix4x4& a, const aiMatrix4x4& b) {
-    aiMatrix4x4 result;
-    for (unsigned int i = 0; i < 4; ++i) {
-        for (unsigned int j = 0; j < 4; ++j) {
-            result[i][j] = 0.0f;
-            for (unsigned int k = 0; k < 4; ++k) {
-                result[i][j] += a[i][k] * b[k][j];
-            }
-        }
-    }
-    return result;
-}
+const int N = 21;
+const int M = 19;
+const float CELL_SIZE_3D = 2.0f;
 
-aiVector3D transformVector(const aiMatrix4x4& matrix, const aiVector3D& vector) {
-    aiVector3D result;
-    result.x = matrix.a1 * vector.x + matrix.a2 * vector.y + matrix.a3 * vector.z + matrix.a4;
-    result.y = matrix.b1 * vector.x + matrix.b2 * vector.y + matrix.b3 * vector.z + matrix.b4;
-    result.z = matrix.c1 * vector.x + matrix.c2 * vector.y + matrix.c3 * vector.z + matrix.c4;
-    return result;
-}
+const uint64_t gameSeed = static_cast<uint64_t>(std::time(nullptr));
+Game game(M, N, gameSeed);
+ConsoleEventLog consoleLog; // события игры в консоль раз в кадр, не из тика
 
-// Упрощенный класс для загрузки 3D моделей 
-class SimpleModel3DS {
-private:
-    const aiScene* scene;
-    bool loaded;
-    float scaleFactor;
-    Assimp::Importer importer; 
+// Монеты на высоте 0.5, энергетики - 0.8
+PelletRenderer pellets(PelletLayout{ CELL_SIZE_3D, { 0.5f, 0.8f } });
 
+// События кадра: в консоль и в буферы пеллетов (съеденные убираются оттуда)
+class FrameEventListener : public GameEventListener {
 public:
-    SimpleModel3DS() : scene(nullptr), loaded(false), scaleFactor(1.0f) {}
-
-    // Метод для загрузки модели
-    bool loadFromFile(const std::string& filename) {
-        scene = importer.ReadFile(filename,
-            aiProcess_Triangulate |
-            aiProcess_GenSmoothNormals |
-            aiProcess_FlipUVs |
-            aiProcess_JoinIdenticalVertices);
-
-        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
-            std::cerr << "Assimp error: " << importer.GetErrorString() << std::endl;
-            return false;
-        }
-
-        loaded = true;
-        calculateSimpleScale();
-
-        std::cout << "Model loaded: " << filename << std::endl;
-        std::cout << "Meshes: " << scene->mNumMeshes << ", Materials: " << scene->mNumMaterials << std::endl;
-
-        return true;
+    void onGameEvent(const GameEvent& event) override {
+        consoleLog.onGameEvent(event);
+        pellets.getEventListener().onGameEvent(event);
     }
+};
+FrameEventListener frameEvents;
 
-    // Единственный метод рендеринга, поддерживающий тонирование (для призраков)
-    void render(const GLfloat* tintColor = nullptr) const {
-        if (!loaded || !scene) return;
-
-        glPushMatrix();
-        glScalef(scaleFactor, scaleFactor, scaleFactor);
-
-        // Проходим по всем мешам (частям) модели
-        for (unsigned int m = 0; m < scene->mNumMeshes; m++) {
-            const aiMesh* mesh = scene->mMeshes[m];
-
-            // 1. ЛОГИКА ТОНИРОВАНИЯ (для тела призрака)
-            if (tintColor != nullptr && m == 0) {
-                // Устанавливаем переданный цвет
-                glMaterialfv(GL_FRONT, GL_DIFFUSE, tintColor);
-
-                // Фоновый цвет (немного темнее для глубины)
-                GLfloat ambientColor[] = { tintColor[0] * 0.4f, tintColor[1] * 0.4f, tintColor[2] * 0.4f, 1.0f };
-                glMaterialfv(GL_FRONT, GL_AMBIENT, ambientColor);
-
-                // Устанавливаем яркий блик для тела
-                GLfloat ghost_specular[] = { 0.8f, 0.8f, 0.8f, 1.0f };
-                glMaterialfv(GL_FRONT, GL_SPECULAR, ghost_specular);
-                glMaterialf(GL_FRONT, GL_SHININESS, 32.0f);
-
-            }
-            // 2. ЛОГИКА ИСПОЛЬЗОВАНИЯ МАТЕРИАЛОВ ИЗ ФАЙЛА (для глаз или Pacman'а)
-            else {
-                unsigned int materialIndex = mesh->mMaterialIndex;
-                if (materialIndex < scene->mNumMaterials) {
-                    const aiMaterial* material = scene->mMaterials[materialIndex];
-
-                    // Сброс блика/блеска для глаз, чтобы они не выглядели как глянцевый пластик
-                    GLfloat default_specular[] = { 0.1f, 0.1f, 0.1f, 1.0f };
-                    glMaterialfv(GL_FRONT, GL_SPECULAR, default_specular);
-                    glMaterialf(GL_FRONT, GL_SHININESS, 10.0f);
-
-                    // Diffuse (Основной цвет)
-                    aiColor4D diffuseColor;
-                    if (aiGetMaterialColor(material, AI_MATKEY_COLOR_DIFFUSE, &diffuseColor) == AI_SUCCESS) {
-                        GLfloat color[] = { diffuseColor.r, diffuseColor.g, diffuseColor.b, diffuseColor.a };
-                        glMaterialfv(GL_FRONT, GL_DIFFUSE, color);
-                    }
-
-                    // Ambient (Фоновый цвет)
-                    aiColor4D ambientColor;
-                    if (aiGetMaterialColor(material, AI_MATKEY_COLOR_AMBIENT, &ambientColor) == AI_SUCCESS) {
-                        GLfloat color[] = { ambientColor.r, ambientColor.g, ambientColor.b, ambientColor.a };
-                        glMaterialfv(GL_FRONT, GL_AMBIENT, color);
-                    }
-                }
-            }
-
-            // Отрисовываем меш с уже установленным для него материалом
-            renderSimpleMesh(mesh);
-        }
-
-        glPopMatrix();
-    }
-
-private:
-    void calculateSimpleScale() {
-        // Простое вычисление масштаба
-        if (scene->mNumMeshes > 0) {
-            const aiMesh* mesh = scene->mMeshes[0];
-            float maxSize = 0.0f;
-
-            for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
-                const aiVector3D& vertex = mesh->mVertices[i];
-                maxSize = std::max(maxSize, std::abs(vertex.x));
-                maxSize = std::max(maxSize, std::abs(vertex.y));
-                maxSize = std::max(maxSize, std::abs(vertex.z));
-            }
-
-            if (maxSize > 0.0f) {
-                scaleFactor = 1.0f / maxSize;
-            }
-        }
-    }
-
-    void renderSimpleMesh(const aiMesh* mesh) const {
-        // Рендерим треугольники 
-        glBegin(GL_TRIANGLES);
-        for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
-            const aiFace& face = mesh->mFaces[i];
-
-            for (unsigned int j = 0; j < face.mNumIndices; j++) {
-                unsigned int index = face.mIndices[j];
+// Клавиши копятся до ближайшего тика и применяются через applyInput -
+// так же, как при проигрывании записи, поэтому запись точна
+uint8_t pendingInput = 0;
+ReplayRecorder recorder;
+const char* recordPath = nullptr;
+const char* profilePath = nullptr; // --profile: трасса зон при выходе
 
-                // Нормали
-                if (mesh->HasNormals()) {
-                    glNormal3f(mesh->mNormals[index].x,
-                        mesh->mNormals[index].y,
-                        mesh->mNormals[index].z);
-                }
+// --count-allocations: выделения памяти по тикам и кадрам, сводка при выходе
+bool countAllocations = false;
+AllocationStats tickAllocations;
+AllocationStats frameAllocations;
 
-                // Вершины
-                glVertex3f(mesh->mVertices[index].x,
-                    mesh->mVertices[index].y,
-                    mesh->mVertices[index].z);
-            }
-        }
-        glEnd();
-    }
-};
-const int N = 21;
-const int M = 19;
-const float CELL_SIZE_3D = 2.0f;
+// --gl-stats: сколько вызовов состояния OpenGL кадр отправил и сколько пропустил кэш
+bool countGLState = false;
+GLStateStats glStateStats;
 
-Game game(M, N);
+// Режим просмотра записи (--replay): ввод игнорируется, тики берутся из файла
+Replay replay;
+ReplayPlayer* replayPlayer = nullptr;
+const uint32_t REPLAY_SEEK_TICKS = 5 * 60;
 
 // Глобальные переменные для моделей
 SimpleModel3DS pacmanModel;
@@ -219,11 +106,12 @@ public:
         upX = 0; upY = 1; upZ = 0;
     }
 
-    void followPacman(const Pacman& pacman) {
+    // Позиция Пакмана в клетках (уже интерполированная между тиками)
+    void followPacman(float pacmanX, float pacmanY) {
         if (!followMode) return;
 
-        float pacmanX3D = pacman.getX() * CELL_SIZE_3D;
-        float pacmanZ3D = (N - pacman.getY()) * CELL_SIZE_3D;
+        float pacmanX3D = pacmanX * CELL_SIZE_3D;
+        float pacmanZ3D = (N - pacmanY) * CELL_SIZE_3D;
 
         eyeX = pacmanX3D + 12.0f * sin(angleY * M_PI / 180.0f);
         eyeY = 25.0f;
@@ -250,34 +138,60 @@ public:
 
 Camera camera;
 
-// Класс для сохранения и восстановления материалов
-class MaterialSaver {
-private:
-    GLfloat ambient[4];
-    GLfloat diffuse[4];
-    GLfloat specular[4];
-    GLfloat shininess;
+// Симуляция идёт тиками постоянной длины, отрисовка - так часто, как
+// позволяет дисплей. Таймеры призраков рассчитаны на 60 тиков в секунду.
+FixedTimestep timestep(60);
+std::chrono::steady_clock::time_point lastFrameTime;
 
-public:
-    MaterialSaver() {
-        glGetMaterialfv(GL_FRONT, GL_AMBIENT, ambient);
-        glGetMaterialfv(GL_FRONT, GL_DIFFUSE, diffuse);
-        glGetMaterialfv(GL_FRONT, GL_SPECULAR, specular);
-        glGetMaterialfv(GL_FRONT, GL_SHININESS, &shininess);
+// Позиции на предыдущем тике: кадр рисует точку между ним и текущим
+struct EntityPosition {
+    float x, y;
+};
+
+EntityPosition previousPacman;
+std::vector<EntityPosition> previousGhosts;
+
+void rememberPositions() {
+    const auto& pacman = game.getPacman();
+    previousPacman.x = pacman.getX();
+    previousPacman.y = pacman.getY();
+
+    const auto& ghosts = game.getGhosts();
+    previousGhosts.resize(ghosts.size());
+    for (size_t i = 0; i < ghosts.size(); i++) {
+        previousGhosts[i].x = ghosts[i].getX();
+        previousGhosts[i].y = ghosts[i].getY();
     }
+}
 
-    ~MaterialSaver() {
-        glMaterialfv(GL_FRONT, GL_AMBIENT, ambient);
-        glMaterialfv(GL_FRONT, GL_DIFFUSE, diffuse);
-        glMaterialfv(GL_FRONT, GL_SPECULAR, specular);
-        glMaterialf(GL_FRONT, GL_SHININESS, shininess);
+// Прыжок больше чем на клетку за тик - телепорт (смерть, респаун, рестарт):
+// его не сглаживаем, чтобы фигура не проплывала через лабиринт
+EntityPosition interpolate(const EntityPosition& previous, float x, float y, float alpha) {
+    EntityPosition result;
+    if (std::fabs(x - previous.x) > 1.0f || std::fabs(y - previous.y) > 1.0f) {
+        result.x = x;
+        result.y = y;
     }
+    else {
+        result.x = previous.x + (x - previous.x) * alpha;
+        result.y = previous.y + (y - previous.y) * alpha;
+    }
+    return result;
+}
+
+// Сохраняет материал на время рисования объекта. Раньше читал его через
+// glGetMaterialfv, теперь это копия в стек кэша состояния, а при выходе в
+// OpenGL уходят только изменившиеся поля.
+class MaterialSaver {
+public:
+    MaterialSaver() { glState().pushMaterial(); }
+    ~MaterialSaver() { glState().popMaterial(); }
 };
 
 void setupLighting() {
-    glEnable(GL_LIGHTING);
-    glEnable(GL_LIGHT0);
-    glEnable(GL_LIGHT1);
+    glState().enable(GL_LIGHTING);
+    glState().enable(GL_LIGHT0);
+    glState().enable(GL_LIGHT1);
   
 
     // Основной источник света (как солнце)
@@ -286,233 +200,275 @@ void setupLighting() {
     GLfloat light0_diffuse[] = { 0.8f, 0.8f, 0.8f, 1.0f };
     GLfloat light0_specular[] = { 0.5f, 0.5f, 0.5f, 1.0f };
 
-    glLightfv(GL_LIGHT0, GL_POSITION, light0_position);
-    glLightfv(GL_LIGHT0, GL_AMBIENT, light0_ambient);
-    glLightfv(GL_LIGHT0, GL_DIFFUSE, light0_diffuse);
-    glLightfv(GL_LIGHT0, GL_SPECULAR, light0_specular);
+    glState().light(GL_LIGHT0, GL_POSITION, light0_position);
+    glState().light(GL_LIGHT0, GL_AMBIENT, light0_ambient);
+    glState().light(GL_LIGHT0, GL_DIFFUSE, light0_diffuse);
+    glState().light(GL_LIGHT0, GL_SPECULAR, light0_specular);
 
     // Заполняющий свет (рассеянный)
     GLfloat light1_position[] = { 0.0f, 20.0f, 0.0f, 1.0f };
     GLfloat light1_ambient[] = { 0.2f, 0.2f, 0.2f, 1.0f };
     GLfloat light1_diffuse[] = { 0.4f, 0.4f, 0.4f, 1.0f };
 
-    glLightfv(GL_LIGHT1, GL_POSITION, light1_position);
-    glLightfv(GL_LIGHT1, GL_AMBIENT, light1_ambient);
-    glLightfv(GL_LIGHT1, GL_DIFFUSE, light1_diffuse);
+    glState().light(GL_LIGHT1, GL_POSITION, light1_position);
+    glState().light(GL_LIGHT1, GL_AMBIENT, light1_ambient);
+    glState().light(GL_LIGHT1, GL_DIFFUSE, light1_diffuse);
 
     // Настройки материала
     GLfloat mat_specular[] = { 0.5f, 0.5f, 0.5f, 1.0f };
     GLfloat mat_shininess[] = { 50.0f };
-    glMaterialfv(GL_FRONT, GL_SPECULAR, mat_specular);
-    glMaterialfv(GL_FRONT, GL_SHININESS, mat_shininess);
+    glState().material(GL_FRONT, GL_SPECULAR, mat_specular);
+    glState().material(GL_FRONT, GL_SHININESS, mat_shininess);
 }
 
-//  источник света
-void drawLightBulb(float x, float y, float z) {
-    glPushMatrix();
-    glTranslatef(x, y, z);
-    glDisable(GL_LIGHTING);
-    glColor3f(1.0f, 1.0f, 0.8f); 
-    glutSolidSphere(0.5f, 16, 16);
-    glEnable(GL_LIGHTING);
-    glPopMatrix();
+// Проходы очереди: сначала освещённая сцена, потом лампочки без освещения
+enum RenderPass {
+    PASS_LIT,
+    PASS_UNLIT
+};
+
+// Материалы сцены - номера в sceneMaterials и поле материала в ключе.
+// Каждый задан целиком, поэтому порядок отрисовки на цвет не влияет.
+enum SceneMaterial {
+    MATERIAL_NONE,          // без освещения материал не нужен
+    MATERIAL_FLOOR,
+    MATERIAL_WALL,
+    MATERIAL_COIN,
+    MATERIAL_POWER_POINT,
+    MATERIAL_PACMAN_FALLBACK,
+    MATERIAL_GHOST_TINT,    // + GhostColor, последний - уязвимый (синий)
+    MATERIAL_MODEL_FIRST = MATERIAL_GHOST_TINT + 5
+};
+
+// Меши - поле меша в ключе; у моделей по номеру на каждый их меш
+const uint32_t MAX_MODEL_MESHES = 256;
+enum SceneMesh {
+    MESH_FLOOR,
+    MESH_WALLS,
+    MESH_COINS,
+    MESH_POWER_POINTS,
+    MESH_SPHERE,            // glutSolidSphere радиуса scale
+    MESH_PACMAN_MODEL,
+    MESH_GHOST_MODEL = MESH_PACMAN_MODEL + MAX_MODEL_MESHES
+};
+
+std::vector<GLMaterial> sceneMaterials;
+uint32_t pacmanMaterialFirst = 0; // материалы мешей моделей из файлов
+uint32_t ghostMaterialFirst = 0;
+
+// Материалы моделей берутся из файлов, поэтому таблица собирается после загрузки
+void initSceneMaterials() {
+    // Что оставляет setupLighting: цвета по умолчанию и общий блик
+    const GLMaterial base = { { 0.2f, 0.2f, 0.2f, 1.0f }, { 0.8f, 0.8f, 0.8f, 1.0f }, { 0.5f, 0.5f, 0.5f, 1.0f }, 50.0f };
+    const GLMaterial floor = { { 0.1f, 0.1f, 0.1f, 1.0f }, { 0.15f, 0.15f, 0.15f, 1.0f }, { 0.5f, 0.5f, 0.5f, 1.0f }, 1.0f };
+    const GLMaterial wall = { { 0.1f, 0.1f, 0.4f, 1.0f }, { 0.2f, 0.2f, 0.8f, 1.0f }, { 0.3f, 0.3f, 0.5f, 1.0f }, 10.0f };
+    const GLMaterial coin = { { 0.8f, 0.8f, 0.0f, 1.0f }, { 1.0f, 1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 0.5f, 1.0f }, 30.0f };
+    const GLMaterial power = { { 0.8f, 0.8f, 0.8f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f }, 60.0f };
+    GLMaterial pacmanFallback = base;
+    pacmanFallback.diffuse[2] = 0.0f;
+    pacmanFallback.diffuse[0] = pacmanFallback.diffuse[1] = 1.0f;
+
+    sceneMaterials.assign(MATERIAL_MODEL_FIRST, base);
+    sceneMaterials[MATERIAL_FLOOR] = floor;
+    sceneMaterials[MATERIAL_WALL] = wall;
+    sceneMaterials[MATERIAL_COIN] = coin;
+    sceneMaterials[MATERIAL_POWER_POINT] = power;
+    sceneMaterials[MATERIAL_PACMAN_FALLBACK] = pacmanFallback;
+    sceneMaterials[MATERIAL_GHOST_TINT + RED] = SimpleModel3DS::tintMaterial(1.0f, 0.0f, 0.0f);
+    sceneMaterials[MATERIAL_GHOST_TINT + PINK] = SimpleModel3DS::tintMaterial(1.0f, 0.5f, 0.8f);
+    sceneMaterials[MATERIAL_GHOST_TINT + CYAN] = SimpleModel3DS::tintMaterial(0.0f, 1.0f, 1.0f);
+    sceneMaterials[MATERIAL_GHOST_TINT + ORANGE] = SimpleModel3DS::tintMaterial(1.0f, 0.5f, 0.0f);
+    sceneMaterials[MATERIAL_GHOST_TINT + 4] = SimpleModel3DS::tintMaterial(0.0f, 0.0f, 1.0f);
+
+    pacmanMaterialFirst = static_cast<uint32_t>(sceneMaterials.size());
+    for (unsigned int m = 0; m < pacmanModel.getMeshCount(); m++) {
+        sceneMaterials.push_back(pacmanModel.getMeshMaterial(m, base));
+    }
+    ghostMaterialFirst = static_cast<uint32_t>(sceneMaterials.size());
+    for (unsigned int m = 0; m < ghostModel.getMeshCount(); m++) {
+        sceneMaterials.push_back(ghostModel.getMeshMaterial(m, base));
+    }
 }
 
+// Объект кадра: куда и как повернуть меш. Объект 0 - без преобразования
+// (пол, стены, пеллеты уже в координатах мира)
+struct SceneObject {
+    float x, y, z;
+    float angle, axisX, axisY, axisZ;
+    float scale;
+};
 
+// Стены 1.8 x 2.0 x 1.8 в клетке, от пола уровня y = 0
+const WallShape WALL_SHAPE = { CELL_SIZE_3D, 1.8f, 0.0f, 2.0f };
+
+// Запечённые стены: меш собирается заново, только когда карта расставила
+// стены (initializeClassicMap при рестарте и смене уровня)
+WallMeshBuilder wallBuilder;
+MeshData wallData;
+MeshBuffer wallBuffer;
+uint32_t wallVersion = 0;
+
+void rebuildWalls() {
+    WallMeshStats stats = wallBuilder.build(game.getMap(), WALL_SHAPE, wallData);
+    wallBuffer.upload(wallData);
+    wallVersion = game.getMap().getWallVersion();
+    std::cout << "Walls: " << stats.wallCells << " cubes (" << stats.wallCells << " draw calls, "
+        << stats.wallCells * 24 << " vertices) -> 1 draw call, " << wallData.vertexCount()
+        << " vertices, " << stats.quads << " quads" << std::endl;
+}
 
-void drawCube(float x, float y, float z, float width, float height, float depth) {
-    MaterialSaver saver;
-    float hw = width / 2;
-    float hh = height / 2;
-    float hd = depth / 2;
-
-    // Материал для стен
-    GLfloat wall_ambient[] = { 0.1f, 0.1f, 0.4f, 1.0f };
-    GLfloat wall_diffuse[] = { 0.2f, 0.2f, 0.8f, 1.0f };
-    GLfloat wall_specular[] = { 0.3f, 0.3f, 0.5f, 1.0f };
-    glMaterialfv(GL_FRONT, GL_AMBIENT, wall_ambient);
-    glMaterialfv(GL_FRONT, GL_DIFFUSE, wall_diffuse);
-    glMaterialfv(GL_FRONT, GL_SPECULAR, wall_specular);
-    glMaterialf(GL_FRONT, GL_SHININESS, 10.0f);
-
-    glBegin(GL_QUADS);
-    // Передняя грань
-    glNormal3f(0.0f, 0.0f, 1.0f);
-    glVertex3f(x - hw, y - hh, z + hd);
-    glVertex3f(x + hw, y - hh, z + hd);
-    glVertex3f(x + hw, y + hh, z + hd);
-    glVertex3f(x - hw, y + hh, z + hd);
-
-    // Задняя грань
-    glNormal3f(0.0f, 0.0f, -1.0f);
-    glVertex3f(x - hw, y - hh, z - hd);
-    glVertex3f(x - hw, y + hh, z - hd);
-    glVertex3f(x + hw, y + hh, z - hd);
-    glVertex3f(x + hw, y - hh, z - hd);
-
-    // Верхняя грань
-    glNormal3f(0.0f, 1.0f, 0.0f);
-    glVertex3f(x - hw, y + hh, z - hd);
-    glVertex3f(x - hw, y + hh, z + hd);
-    glVertex3f(x + hw, y + hh, z + hd);
-    glVertex3f(x + hw, y + hh, z - hd);
-
-    // Нижняя грань
-    glNormal3f(0.0f, -1.0f, 0.0f);
-    glVertex3f(x - hw, y - hh, z - hd);
-    glVertex3f(x + hw, y - hh, z - hd);
-    glVertex3f(x + hw, y - hh, z + hd);
-    glVertex3f(x - hw, y - hh, z + hd);
-
-    // Левая грань
-    glNormal3f(-1.0f, 0.0f, 0.0f);
-    glVertex3f(x - hw, y - hh, z - hd);
-    glVertex3f(x - hw, y - hh, z + hd);
-    glVertex3f(x - hw, y + hh, z + hd);
-    glVertex3f(x - hw, y + hh, z - hd);
-
-    // Правая грань
-    glNormal3f(1.0f, 0.0f, 0.0f);
-    glVertex3f(x + hw, y - hh, z - hd);
-    glVertex3f(x + hw, y + hh, z - hd);
-    glVertex3f(x + hw, y + hh, z + hd);
-    glVertex3f(x + hw, y - hh, z + hd);
-    glEnd();
+// Кадр целиком - очередь элементов с ключами (проход, материал, меш,
+// глубина). Память под очередь и объекты резервируется при запуске.
+RenderQueue renderQueue;
+std::vector<SceneObject> sceneObjects;
+RenderQueueStats renderQueueStats;
+const float RENDER_DEPTH_RANGE = 200.0f; // дальняя плоскость камеры
+
+uint32_t addSceneObject(float x, float y, float z, float angle, float axisX, float axisY, float axisZ, float scale) {
+    SceneObject object = { x, y, z, angle, axisX, axisY, axisZ, scale };
+    sceneObjects.push_back(object);
+    return static_cast<uint32_t>(sceneObjects.size() - 1);
 }
 
-void drawFloor() {
-    MaterialSaver saver;
-    GLfloat floor_ambient[] = { 0.1f, 0.1f, 0.1f, 1.0f };
-    GLfloat floor_diffuse[] = { 0.15f, 0.15f, 0.15f, 1.0f };
-    glMaterialfv(GL_FRONT, GL_AMBIENT, floor_ambient);
-    glMaterialfv(GL_FRONT, GL_DIFFUSE, floor_diffuse);
-    glMaterialf(GL_FRONT, GL_SHININESS, 1.0f);
-
-    glBegin(GL_QUADS);
-    glNormal3f(0.0f, 1.0f, 0.0f);
-    glVertex3f(-5.0f, -1.0f, -5.0f);
-    glVertex3f(M * CELL_SIZE_3D + 5.0f, -1.0f, -5.0f);
-    glVertex3f(M * CELL_SIZE_3D + 5.0f, -1.0f, N * CELL_SIZE_3D + 5.0f);
-    glVertex3f(-5.0f, -1.0f, N * CELL_SIZE_3D + 5.0f);
-    glEnd();
+void submitDraw(RenderPass pass, uint32_t material, uint32_t mesh, uint32_t object) {
+    uint32_t depth = 0;
+    if (object != 0) {
+        const SceneObject& o = sceneObjects[object];
+        float dx = o.x - camera.eyeX, dy = o.y - camera.eyeY, dz = o.z - camera.eyeZ;
+        depth = renderDepth(std::sqrt(dx * dx + dy * dy + dz * dz), RENDER_DEPTH_RANGE);
+    }
+    renderQueue.submit(renderKey(pass, material, mesh, depth), object);
 }
 
-void drawSphere(float x, float y, float z, float radius, int segments) {
-    glPushMatrix();
-    glTranslatef(x, y, z);
-    glutSolidSphere(radius, segments, segments);
-    glPopMatrix();
+// Модель - по элементу на меш: одинаковые меши разных призраков потом
+// рисуются подряд с одной привязкой буфера
+void submitModel(const SimpleModel3DS& model, uint32_t firstMesh, uint32_t firstMaterial, uint32_t tint, uint32_t object) {
+    unsigned int meshCount = std::min(model.getMeshCount(), MAX_MODEL_MESHES);
+    for (unsigned int m = 0; m < meshCount; m++) {
+        uint32_t material = tint != MATERIAL_NONE && m == 0 ? tint : firstMaterial + m;
+        submitDraw(PASS_LIT, material, firstMesh + m, object);
+    }
 }
 
-void drawPacman3D(float x, float y, float z, float size, float mouthAngle, float rotationY) {
-    MaterialSaver saver; 
-    glPushMatrix();
-    glTranslatef(x, y, z);
-    glRotatef(rotationY, 0, 1, 0);
+void buildRenderQueue(float alpha, const EntityPosition& pacmanPosition) {
+    renderQueue.clear();
+    sceneObjects.clear();
+    addSceneObject(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f);
 
-   
+    // Лампочки на месте источников света
+    submitDraw(PASS_UNLIT, MATERIAL_NONE, MESH_SPHERE,
+        addSceneObject(M * CELL_SIZE_3D / 2.0f, 30.0f, N * CELL_SIZE_3D / 2.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.5f));
+    submitDraw(PASS_UNLIT, MATERIAL_NONE, MESH_SPHERE, addSceneObject(0.0f, 20.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.5f));
 
+    submitDraw(PASS_LIT, MATERIAL_FLOOR, MESH_FLOOR, 0);
+    submitDraw(PASS_LIT, MATERIAL_WALL, MESH_WALLS, 0);
+    if (pellets.count(PELLET_COIN) > 0) submitDraw(PASS_LIT, MATERIAL_COIN, MESH_COINS, 0);
+    if (pellets.count(PELLET_POWER_POINT) > 0) submitDraw(PASS_LIT, MATERIAL_POWER_POINT, MESH_POWER_POINTS, 0);
+
+    const auto& pacman = game.getPacman();
+    float pacmanX = pacmanPosition.x * CELL_SIZE_3D;
+    float pacmanZ = (N - pacmanPosition.y) * CELL_SIZE_3D;
     if (pacmanModelLoaded) {
-        pacmanModel.render();
+        uint32_t object = addSceneObject(pacmanX, 1.0f, pacmanZ, pacman.getRotationY(), 0.0f, 1.0f, 0.0f, pacmanModel.getScale());
+        submitModel(pacmanModel, MESH_PACMAN_MODEL, pacmanMaterialFirst, MATERIAL_NONE, object);
     }
     else {
-        // Fallback 
-        GLfloat yellow_diffuse[] = { 1.0f, 1.0f, 0.0f, 1.0f };
-        glMaterialfv(GL_FRONT, GL_DIFFUSE, yellow_diffuse);
-        glutSolidSphere(size, 16, 16);
+        uint32_t object = addSceneObject(pacmanX, 1.0f, pacmanZ, pacman.getRotationY(), 0.0f, 1.0f, 0.0f, 0.6f);
+        submitDraw(PASS_LIT, MATERIAL_PACMAN_FALLBACK, MESH_SPHERE, object);
     }
 
-    glPopMatrix();
+    const float ghostSize = 6.0f;
+    const auto& ghosts = game.getGhosts();
+    int ghostIndex = 0;
+    for (const auto& ghost : ghosts) {
+        EntityPosition position = { ghost.getX(), ghost.getY() };
+        if (ghostIndex < static_cast<int>(previousGhosts.size())) {
+            position = interpolate(previousGhosts[ghostIndex], position.x, position.y, alpha);
+        }
+        ghostIndex++;
+        float ghostX = position.x * CELL_SIZE_3D;
+        float ghostZ = (N - position.y) * CELL_SIZE_3D;
+        uint32_t tint = MATERIAL_GHOST_TINT + (ghost.isVulnerable() ? 4 : ghost.getColor());
+        if (ghostModelLoaded) {
+            uint32_t object = addSceneObject(ghostX, ghostSize * 0.5f, ghostZ, -90.0f, 1.0f, 0.0f, 0.0f, ghostModel.getScale());
+            submitModel(ghostModel, MESH_GHOST_MODEL, ghostMaterialFirst, tint, object);
+        }
+        else {
+            uint32_t object = addSceneObject(ghostX, ghostSize * 0.5f, ghostZ, -90.0f, 1.0f, 0.0f, 0.0f, ghostSize);
+            submitDraw(PASS_LIT, tint, MESH_SPHERE, object);
+        }
+    }
 }
 
-void drawGhost3D(float x, float y, float z, float size, GhostColor color, bool isVulnerable, int ghostIndex) {
-    MaterialSaver saver;
-    glPushMatrix();
-    glTranslatef(x, y + size * 0.5f, z);
-    glRotatef(-90.0f, 1.0f, 0.0f, 0.0f);
+// Исполнитель очереди: состояние OpenGL меняется, только когда его
+// меняет ключ, а сами вызовы идут через кэш glState()
+class SceneRenderer : public RenderBackend {
+private:
+    static const MeshBuffer* buffer(uint32_t mesh) {
+        if (mesh == MESH_WALLS) return &wallBuffer;
+        if (mesh >= MESH_GHOST_MODEL) return &ghostModel.getMeshBuffer(mesh - MESH_GHOST_MODEL);
+        if (mesh >= MESH_PACMAN_MODEL) return &pacmanModel.getMeshBuffer(mesh - MESH_PACMAN_MODEL);
+        return nullptr; // пол, пеллеты и сферы привязывают своё сами
+    }
 
-    float r, g, b;
-    if (isVulnerable) {
-        r = 0.0f; g = 0.0f; b = 1.0f; // Синий для уязвимых
+    static void drawFloor() {
+        glBegin(GL_QUADS);
+        glNormal3f(0.0f, 1.0f, 0.0f);
+        glVertex3f(-5.0f, -1.0f, -5.0f);
+        glVertex3f(M * CELL_SIZE_3D + 5.0f, -1.0f, -5.0f);
+        glVertex3f(M * CELL_SIZE_3D + 5.0f, -1.0f, N * CELL_SIZE_3D + 5.0f);
+        glVertex3f(-5.0f, -1.0f, N * CELL_SIZE_3D + 5.0f);
+        glEnd();
     }
-    else {
-        switch (color) {
-        case RED: r = 1.0f; g = 0.0f; b = 0.0f; break;
-        case PINK: r = 1.0f; g = 0.5f; b = 0.8f; break;
-        case CYAN: r = 0.0f; g = 1.0f; b = 1.0f; break;
-        case ORANGE: r = 1.0f; g = 0.5f; b = 0.0f; break;
-        default: r = 1.0f; g = 0.0f; b = 0.0f; break;
+
+public:
+    void beginPass(uint32_t pass) override {
+        if (pass == PASS_UNLIT) {
+            glState().disable(GL_LIGHTING);
+            glColor3f(1.0f, 1.0f, 0.8f);
+        }
+        else {
+            glState().enable(GL_LIGHTING);
         }
     }
 
-    
+    void bindMaterial(uint32_t material) override {
+        if (material != MATERIAL_NONE) glState().material(GL_FRONT, sceneMaterials[material]);
+    }
 
-    if (ghostModelLoaded) {
-      
-        GLfloat tintColor[] = { r, g, b, 1.0f };
-        
-        ghostModel.render(tintColor); 
+    void bindMesh(uint32_t mesh) override {
+        if (const MeshBuffer* meshBuffer = buffer(mesh)) meshBuffer->bind();
     }
-    else {
-        // Fallback: цвет для сферы
-        GLfloat fallback_color[] = { r, g, b, 1.0f };
-        glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, fallback_color);
-        
-        GLfloat ghost_specular[] = { 0.8f, 0.8f, 0.8f, 1.0f };
-        glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, ghost_specular);
-        glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, 32.0f);
-        glutSolidSphere(size, 16, 16);
+
+    void unbindMesh(uint32_t mesh) override {
+        if (const MeshBuffer* meshBuffer = buffer(mesh)) meshBuffer->unbind();
     }
 
-    glPopMatrix();
-}
-void drawMap3D() {
-    const auto& map = game.getMap();
-    const auto& grid = map.getGrid();
-
-    drawFloor();
-
-    for (int i = 0; i < map.getHeight(); i++) {
-        for (int j = 0; j < map.getWidth(); j++) {
-            float x = j * CELL_SIZE_3D;
-            float z = (N - i) * CELL_SIZE_3D;
-
-            switch (grid[i][j].type) {
-            case WALL:
-                drawCube(x, 1.0f, z, 1.8f, 2.0f, 1.8f);
-                break;
-            case COIN: {
-                MaterialSaver saver;
-                GLfloat coin_ambient[] = { 0.8f, 0.8f, 0.0f, 1.0f };
-                GLfloat coin_diffuse[] = { 1.0f, 1.0f, 0.0f, 1.0f };
-                GLfloat coin_specular[] = { 1.0f, 1.0f, 0.5f, 1.0f };
-                glMaterialfv(GL_FRONT, GL_AMBIENT, coin_ambient);
-                glMaterialfv(GL_FRONT, GL_DIFFUSE, coin_diffuse);
-                glMaterialfv(GL_FRONT, GL_SPECULAR, coin_specular);
-                glMaterialf(GL_FRONT, GL_SHININESS, 30.0f);
-                drawSphere(x, 0.5f, z, 0.2f, 8);
-                break;
-            }
-            case POWER_POINT: {
-                MaterialSaver saver;
-                GLfloat power_ambient[] = { 0.8f, 0.8f, 0.8f, 1.0f };
-                GLfloat power_diffuse[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-                GLfloat power_specular[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-                glMaterialfv(GL_FRONT, GL_AMBIENT, power_ambient);
-                glMaterialfv(GL_FRONT, GL_DIFFUSE, power_diffuse);
-                glMaterialfv(GL_FRONT, GL_SPECULAR, power_specular);
-                glMaterialf(GL_FRONT, GL_SHININESS, 60.0f);
-                drawSphere(x, 0.8f, z, 0.3f, 12);
-                break;
-            }
-            case EMPTY:
-                break;
-            }
+    void draw(uint32_t mesh, uint32_t object) override {
+        switch (mesh) {
+        case MESH_FLOOR: drawFloor(); return;
+        case MESH_WALLS: wallBuffer.drawBound(); return;
+        case MESH_COINS: pellets.draw(PELLET_COIN, 0.2f); return;
+        case MESH_POWER_POINTS: pellets.draw(PELLET_POWER_POINT, 0.3f); return;
+        }
+
+        const SceneObject& o = sceneObjects[object];
+        glPushMatrix();
+        glTranslatef(o.x, o.y, o.z);
+        if (o.angle != 0.0f) glRotatef(o.angle, o.axisX, o.axisY, o.axisZ);
+        if (mesh == MESH_SPHERE) {
+            glutSolidSphere(o.scale, 16, 16);
+        }
+        else {
+            glScalef(o.scale, o.scale, o.scale);
+            buffer(mesh)->drawBound();
         }
+        glPopMatrix();
     }
-}
+};
+SceneRenderer sceneRenderer;
 
-void drawText(float x, float y, const std::string& text) {
+void drawText(float x, float y, const char* text) {
     glMatrixMode(GL_PROJECTION);
     glPushMatrix();
     glLoadIdentity();
@@ -522,13 +478,13 @@ void drawText(float x, float y, const std::string& text) {
     glPushMatrix();
     glLoadIdentity();
 
-    glDisable(GL_LIGHTING);
+    glState().disable(GL_LIGHTING);
     glColor3f(1.0f, 1.0f, 1.0f);
     glRasterPos2f(x, y);
-    for (char c : text) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, c);
+    for (const char* c = text; *c; c++) {
+        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, *c);
     }
-    glEnable(GL_LIGHTING);
+    glState().enable(GL_LIGHTING);
 
     glPopMatrix();
     glMatrixMode(GL_PROJECTION);
@@ -549,94 +505,187 @@ void setupCamera() {
 }
 
 void display() {
+    AllocationWindow frameWindow;
+    PROFILE_ZONE("display");
+    glState().beginFrame();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    setupLighting();
-    setupCamera();
-
-    glEnable(GL_DEPTH_TEST);
-
-    drawLightBulb(M * CELL_SIZE_3D / 2.0f, 30.0f, N * CELL_SIZE_3D / 2.0f);
-    drawLightBulb(0.0f, 20.0f, 0.0f);
-
-    drawMap3D();
-
+    float alpha = timestep.alpha();
     const auto& pacman = game.getPacman();
-    float pacmanX = pacman.getX() * CELL_SIZE_3D;
-    float pacmanZ = (N - pacman.getY()) * CELL_SIZE_3D;
+    EntityPosition pacmanPosition = interpolate(previousPacman, pacman.getX(), pacman.getY(), alpha);
+    camera.followPacman(pacmanPosition.x, pacmanPosition.y);
 
-    drawPacman3D(pacmanX, 1.0f, pacmanZ, 0.6f, pacman.getMouthAngle(), pacman.getRotationY());
+    {
+        PROFILE_ZONE("lighting setup");
+        setupLighting();
+        setupCamera();
 
-    int ghostIndex = 0;
-    for (const auto& ghost : game.getGhosts()) {
-        float ghostX = ghost.getX() * CELL_SIZE_3D;
-        float ghostZ = (N - ghost.getY()) * CELL_SIZE_3D;
-        drawGhost3D(ghostX, 0, ghostZ, 6.0f, ghost.getColor(), ghost.isVulnerable(), ghostIndex);
-        ghostIndex++;
+        glState().enable(GL_DEPTH_TEST);
     }
 
-    glDisable(GL_LIGHTING);
-    glDisable(GL_DEPTH_TEST);
+    {
+        PROFILE_ZONE("build render queue");
+        if (wallVersion != game.getMap().getWallVersion()) rebuildWalls();
+        pellets.sync(game.getMap());
+        buildRenderQueue(alpha, pacmanPosition);
+        renderQueue.sort();
+    }
 
-    drawText(10, 750, "SCORE: " + std::to_string(game.getScore()));
-    drawText(500, 750, "HIGH SCORE: " + std::to_string(game.getHighScore()));
-    drawText(1000, 750, "LEVEL: " + std::to_string(game.getLevel()));
+    {
+        PROFILE_ZONE("execute render queue");
+        MaterialSaver saver;
+        RenderQueueCounts counts = renderQueue.execute(sceneRenderer);
+        if (countGLState) renderQueueStats.add(counts);
+    }
+
+    {
+        PROFILE_ZONE("HUD text");
+        glState().disable(GL_LIGHTING);
+        glState().disable(GL_DEPTH_TEST);
+
+        // Строки собираются на стеке: кадр не выделяет память
+        char line[32];
+        std::snprintf(line, sizeof(line), "SCORE: %d", game.getScore());
+        drawText(10, 750, line);
+        std::snprintf(line, sizeof(line), "HIGH SCORE: %d", game.getHighScore());
+        drawText(500, 750, line);
+        std::snprintf(line, sizeof(line), "LEVEL: %d", game.getLevel());
+        drawText(1000, 750, line);
    
 
-    if (!game.isGameStarted()) {
-        drawText(550, 400, "READY!");
-    }
+        if (!game.isGameStarted()) {
+            drawText(550, 400, "READY!");
+        }
 
-    if (game.isGameOver()) {
-        drawText(520, 400, "GAME OVER");
-        drawText(480, 370, "Press R to restart");
-    }
+        if (game.isGameOver()) {
+            drawText(520, 400, "GAME OVER");
+            drawText(480, 370, "Press R to restart");
+        }
 
-    if (game.isLevelComplete()) {
-        drawText(500, 400, "LEVEL COMPLETE!");
-        drawText(470, 370, "Press SPACE to continue");
+        if (game.isLevelComplete()) {
+            drawText(500, 400, "LEVEL COMPLETE!");
+            drawText(470, 370, "Press SPACE to continue");
+        }
     }
 
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_LIGHTING);
+    glState().enable(GL_DEPTH_TEST);
+    glState().enable(GL_LIGHTING);
 
     glutSwapBuffers();
+    if (countAllocations) frameAllocations.add(frameWindow.elapsed());
+    if (countGLState) glStateStats.add(glState().frameCounts());
 }
 
 void reshape(int width, int height) {
     glViewport(0, 0, width, height);
 }
 
-void update(int value) {
-    game.update();
-    camera.followPacman(game.getPacman());
+// Выполняет тики, накопившиеся с прошлого кадра, и просит новый кадр.
+// Сколько бы ни стоил кадр, игра идёт со скоростью тиков, а не кадров.
+void idle() {
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - lastFrameTime).count();
+    lastFrameTime = now;
+
+    PROFILE_ZONE("idle ticks");
+    int ticks = timestep.advance(elapsed);
+    for (int i = 0; i < ticks; i++) {
+        AllocationWindow tickWindow;
+        rememberPositions();
+        if (replayPlayer) {
+            replayPlayer->step();
+        }
+        else {
+            recorder.step(game, pendingInput);
+            pendingInput = 0;
+        }
+        if (countAllocations) tickAllocations.add(tickWindow.elapsed());
+    }
+    game.getEvents().drain(frameEvents);
     glutPostRedisplay();
-    glutTimerFunc(10, update, 0);
+}
+
+void quit() {
+    if (recordPath) {
+        if (recorder.getReplay().save(recordPath)) {
+            std::cout << "Replay saved to " << recordPath << std::endl;
+        }
+        else {
+            std::cout << "Failed to save replay to " << recordPath << std::endl;
+        }
+    }
+    if (profilePath) {
+        Profiler::setEnabled(false);
+        Profiler::printSummary(stdout);
+        if (Profiler::writeChromeTrace(profilePath)) {
+            std::cout << "Profile trace saved to " << profilePath << " (open in chrome://tracing)" << std::endl;
+        }
+        else {
+            std::cout << "Failed to save profile trace to " << profilePath << std::endl;
+        }
+    }
+    if (countAllocations) {
+        AllocationTracker::setEnabled(false);
+        tickAllocations.print(stdout, "tick");
+        frameAllocations.print(stdout, "frame");
+        AllocationTracker::printSites(stdout);
+    }
+    if (countGLState) {
+        glStateStats.print(stdout);
+        renderQueueStats.print(stdout);
+    }
+    pacmanModel.release();
+    ghostModel.release();
+    wallBuffer.release();
+    pellets.release();
+    exit(0);
+}
+
+// Перемотка записи на delta тиков (через ближайший снимок)
+void seekReplay(int delta) {
+    long long target = static_cast<long long>(replayPlayer->getTick()) + delta;
+    if (target < 0) target = 0;
+    replayPlayer->seek(static_cast<uint32_t>(target));
+    rememberPositions();
 }
 
 void keyboard(unsigned char key, int x, int y) {
-    if (key != 27 && key != 'r' && key != 'R' && key != 'c' && key != 'C' && key != 'q' && key != 'e') {
-        game.startGame();
+    if (replayPlayer) {
+        switch (key) {
+        case ',': case '<': seekReplay(-static_cast<int>(REPLAY_SEEK_TICKS)); break;
+        case '.': case '>': seekReplay(static_cast<int>(REPLAY_SEEK_TICKS)); break;
+        case 27: quit(); break;
+        }
+        return;
+    }
+
+    // Пробел на экране "LEVEL COMPLETE" только переключает уровень, а
+    // стартует следующий уже новое нажатие; в остальное время он - старт
+    bool startKey = key != ' ' || !game.isLevelComplete();
+    if (startKey && key != 27 && key != 'r' && key != 'R' && key != 'c' && key != 'C' && key != 'q' && key != 'e') {
+        pendingInput |= INPUT_START;
     }
 
     switch (key) {
-    case 'w': case 'W': game.setPacmanDirection(0, 1); break;
-    case 's': case 'S': game.setPacmanDirection(0, -1); break;
-    case 'a': case 'A': game.setPacmanDirection(-1, 0); break;
-    case 'd': case 'D': game.setPacmanDirection(1, 0); break;
-    case ' ': if (game.isLevelComplete()) game.nextLevel(); break;
-    case 'r': case 'R': game.restart(); break;
-    case 27: exit(0); break;
+    case 'w': case 'W': pendingInput = withAction(pendingInput, ACTION_UP); break;
+    case 's': case 'S': pendingInput = withAction(pendingInput, ACTION_DOWN); break;
+    case 'a': case 'A': pendingInput = withAction(pendingInput, ACTION_LEFT); break;
+    case 'd': case 'D': pendingInput = withAction(pendingInput, ACTION_RIGHT); break;
+    case ' ': pendingInput |= INPUT_NEXT_LEVEL; break;
+    case 'r': case 'R': pendingInput |= INPUT_RESTART; break;
+    case 27: quit(); break;
     }
 }
 
 void specialKeys(int key, int x, int y) {
-    game.startGame();
+    if (replayPlayer) return;
+
+    pendingInput |= INPUT_START;
     switch (key) {
-    case GLUT_KEY_UP: game.setPacmanDirection(0, 1); break;
-    case GLUT_KEY_DOWN: game.setPacmanDirection(0, -1); break;
-    case GLUT_KEY_LEFT: game.setPacmanDirection(-1, 0); break;
-    case GLUT_KEY_RIGHT: game.setPacmanDirection(1, 0); break;
+    case GLUT_KEY_UP: pendingInput = withAction(pendingInput, ACTION_UP); break;
+    case GLUT_KEY_DOWN: pendingInput = withAction(pendingInput, ACTION_DOWN); break;
+    case GLUT_KEY_LEFT: pendingInput = withAction(pendingInput, ACTION_LEFT); break;
+    case GLUT_KEY_RIGHT: pendingInput = withAction(pendingInput, ACTION_RIGHT); break;
     }
 }
 
@@ -645,11 +694,58 @@ int main(int argc, char** argv) {
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
     glutInitWindowSize(1200, 800);
     glutCreateWindow("Pac-Man 3D with Assimp Models");
+    const GLCapabilities& capabilities = initGLExtensions();
+    std::cout << "Vertex buffers: " << (capabilities.vertexBuffers ? "yes" : "no")
+        << ", vertex arrays: " << (capabilities.vertexArrays ? "yes" : "no") << std::endl;
+    glState().reset(); // контекст только что создан: состояние по умолчанию
+
+    // glutInit уже забрал свои аргументы, остальные - наши
+    const char* replayPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+            timestep.setTickRate(std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profilePath = argv[++i];
+            Profiler::setEnabled(true);
+        }
+        else if (std::strcmp(argv[i], "--count-allocations") == 0) {
+            countAllocations = true;
+            AllocationTracker::setEnabled(true);
+        }
+        else if (std::strcmp(argv[i], "--gl-stats") == 0) {
+            countGLState = true;
+        }
+    }
+
+    if (replayPath) {
+        if (replay.load(replayPath) && replay.getWidth() == M && replay.getHeight() == N) {
+            replayPlayer = new ReplayPlayer(replay, game);
+            std::cout << "Playing replay " << replayPath << " (" << replay.getTickCount()
+                << " ticks), ',' and '.' seek by 5 seconds" << std::endl;
+        }
+        else {
+            std::cout << "Failed to load replay " << replayPath << std::endl;
+        }
+    }
+    if (!replayPlayer) {
+        recorder.start(game, gameSeed);
+        recorder.reserve(static_cast<uint32_t>(timestep.getTickRate()) * 60 * 60); // час игры
+    }
 
     // Загружаем модели через Assimp
     std::cout << "--- Loading Pacman Model ---" << std::endl;
     pacmanModelLoaded = pacmanModel.loadFromFile("pacman.3ds");
     if (pacmanModelLoaded) {
+        std::cout << "Model loaded: pacman.3ds" << std::endl;
+        std::cout << "Meshes: " << pacmanModel.getMeshCount() << ", Materials: " << pacmanModel.getMaterialCount() << std::endl;
+        pacmanModel.upload();
         std::cout << "Pacman 3DS model loaded successfully!" << std::endl;
     }
     else {
@@ -659,16 +755,26 @@ int main(int argc, char** argv) {
     std::cout << "\n--- Loading Ghost Model ---" << std::endl;
     ghostModelLoaded = ghostModel.loadFromFile("ghost.3ds");
     if (ghostModelLoaded) {
+        std::cout << "Model loaded: ghost.3ds" << std::endl;
+        std::cout << "Meshes: " << ghostModel.getMeshCount() << ", Materials: " << ghostModel.getMaterialCount() << std::endl;
+        ghostModel.upload();
         std::cout << "Ghost 3DS model loaded successfully!" << std::endl;
     }
     else {
         std::cout << "Failed to load Ghost 3DS model, using default sphere." << std::endl;
     }
 
+    pellets.init();
+    std::cout << "Pellets: " << (pellets.isInstanced() ? "instanced" : "one shared sphere per pellet") << std::endl;
+
+    initSceneMaterials();
+    renderQueue.reserve(256);
+    sceneObjects.reserve(16);
+
     std::cout << "\n---------------------------\n" << std::endl;
 
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_NORMALIZE);
+    glState().enable(GL_DEPTH_TEST);
+    glState().enable(GL_NORMALIZE);
     glShadeModel(GL_SMOOTH);
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
@@ -676,12 +782,20 @@ int main(int argc, char** argv) {
     glutReshapeFunc(reshape);
     glutKeyboardFunc(keyboard);
     glutSpecialFunc(specialKeys);
-    glutTimerFunc(10, update, 0);
+    glutIdleFunc(idle);
+
+    rememberPositions();
+    lastFrameTime = std::chrono::steady_clock::now();
 
     std::cout << "Pac-Man 3D with Assimp Models Started!" << std::endl;
     std::cout << "Move with WASD or Arrow Keys" << std::endl;
     std::cout << "Press 'R' to restart game" << std::endl;
+    std::cout << "Use --record FILE to save a replay on exit, --replay FILE to watch one" << std::endl;
+    std::cout << "Use --profile FILE to write a Chrome trace of frame and tick zones on exit" << std::endl;
+    std::cout << "Use --count-allocations to print heap allocations per tick and frame on exit" << std::endl;
+    std::cout << "Use --gl-stats to print GL state calls and render queue binds per frame on exit" << std::endl;
     std::cout << "Press 'ESC' to exit" << std::endl;
+    std::cout << "Simulation: " << timestep.getTickRate() << " ticks/s (--tick-rate N)" << std::endl;
 
     glutMainLoop();
     return 0;
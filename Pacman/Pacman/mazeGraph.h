@@ -0,0 +1,131 @@
+#ifndef MAZEGRAPH_H
+#define MAZEGRAPH_H
+
+#include "cell.h"
+#include <cstdint>
+#include <vector>
+
+// Развилка (или тупик): проходимая клетка, у которой выходов не два
+struct MazeNode {
+    int x, y;
+    uint8_t exits;
+    int edges[4]; // ребро по каждому направлению MAZE_DIRECTIONS или -1
+};
+
+// Коридор между двумя развилками. fromDir - направление выхода из from,
+// toDir - направление выхода из to обратно в этот же коридор.
+struct MazeEdge {
+    int from, to;
+    int fromDir, toDir;
+    int length; // число шагов от from до to
+};
+
+// Граф развилок и коридоров лабиринта для ботов и инструментов.
+// Каждая проходимая клетка - либо узел, либо лежит ровно на одном ребре.
+class MazeGraph {
+private:
+    std::vector<MazeNode> nodes;
+    std::vector<MazeEdge> edges;
+    std::vector<int> tileNodes; // индекс узла для клетки или -1
+    std::vector<int> tileEdges; // индекс ребра для клетки коридора или -1
+    int width, height;
+
+    int tile(int x, int y) const { return y * width + x; }
+
+    template <typename Map>
+    void traceEdge(const Map& map, int from, int dir) {
+        int edgeIndex = static_cast<int>(edges.size());
+        int x = nodes[from].x;
+        int y = nodes[from].y;
+        int d = dir;
+        int length = 0;
+
+        for (;;) {
+            x += MAZE_DIRECTIONS[d][0];
+            y += MAZE_DIRECTIONS[d][1];
+            length++;
+            if (tileNodes[tile(x, y)] >= 0) break;
+
+            // Клетка коридора: два выхода, идём в тот, что не ведёт назад
+            tileEdges[tile(x, y)] = edgeIndex;
+            uint8_t exits = map.exitMask(x, y) & ~(1 << ((d + 2) & 3));
+            d = firstDirection(exits);
+        }
+
+        MazeEdge edge;
+        edge.from = from;
+        edge.to = tileNodes[tile(x, y)];
+        edge.fromDir = dir;
+        edge.toDir = (d + 2) & 3;
+        edge.length = length;
+        edges.push_back(edge);
+
+        nodes[edge.from].edges[edge.fromDir] = edgeIndex;
+        nodes[edge.to].edges[edge.toDir] = edgeIndex;
+    }
+
+    // Первое направление из маски (маска коридорной клетки не пуста)
+    static int firstDirection(uint8_t bits) {
+        for (int d = 0; d < 4; d++) {
+            if ((bits >> d) & 1) return d;
+        }
+        return 0;
+    }
+
+public:
+    MazeGraph() : width(0), height(0) {}
+
+    // Map должна давать getWidth/getHeight, canMove и exitMask (см. GameMap)
+    template <typename Map>
+    void build(const Map& map) {
+        width = map.getWidth();
+        height = map.getHeight();
+        nodes.clear();
+        edges.clear();
+        tileNodes.assign(static_cast<size_t>(width) * height, -1);
+        tileEdges.assign(static_cast<size_t>(width) * height, -1);
+
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                if (!map.canMove(static_cast<float>(x), static_cast<float>(y))) continue;
+                uint8_t exits = map.exitMask(x, y);
+                if (countExits(exits) == 2) continue;
+
+                MazeNode node;
+                node.x = x;
+                node.y = y;
+                node.exits = exits;
+                for (int d = 0; d < 4; d++) node.edges[d] = -1;
+                tileNodes[tile(x, y)] = static_cast<int>(nodes.size());
+                nodes.push_back(node);
+            }
+        }
+
+        // Каждый коридор проходим один раз: со второго конца он уже отмечен.
+        // Замкнутые кольца без развилок в граф не попадают.
+        for (int n = 0; n < static_cast<int>(nodes.size()); n++) {
+            for (int d = 0; d < 4; d++) {
+                if (((nodes[n].exits >> d) & 1) && nodes[n].edges[d] < 0) {
+                    traceEdge(map, n, d);
+                }
+            }
+        }
+    }
+
+    const std::vector<MazeNode>& getNodes() const { return nodes; }
+    const std::vector<MazeEdge>& getEdges() const { return edges; }
+
+    // Узел в клетке (x, y) или -1
+    int nodeAt(int x, int y) const {
+        if (x < 0 || x >= width || y < 0 || y >= height) return -1;
+        return tileNodes[tile(x, y)];
+    }
+
+    // Коридор, на котором лежит клетка (x, y), или -1 (стена, узел)
+    int edgeAt(int x, int y) const {
+        if (x < 0 || x >= width || y < 0 || y >= height) return -1;
+        return tileEdges[tile(x, y)];
+    }
+};
+
+#endif
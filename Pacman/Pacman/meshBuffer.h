@@ -0,0 +1,144 @@
+#ifndef MESHBUFFER_H
+#define MESHBUFFER_H
+
+#include "glExtensions.h"
+#include "meshData.h"
+#include <cstdint>
+#include <vector>
+
+static_assert(sizeof(GLuint) == sizeof(uint32_t), "indices are uploaded as GL_UNSIGNED_INT");
+
+// MeshData в буферах видеокарты (VBO/IBO, и VAO, если он есть); рисуется
+// одним glDrawElements. Без поддержки буферов держит копию данных и рисует
+// из обычных массивов вершин. Все методы - только при живом контексте.
+class MeshBuffer {
+private:
+    std::vector<float> vertices;   // копия только без VBO
+    std::vector<uint32_t> indices;
+    GLsizei indexCount;
+    size_t vertexCount;
+    GLuint vertexBuffer;
+    GLuint indexBuffer;
+    GLuint vertexArray;
+
+    static const GLvoid* floatOffset(const float* base, size_t floats) {
+        return reinterpret_cast<const GLvoid*>(reinterpret_cast<uintptr_t>(base) + floats * sizeof(float));
+    }
+
+    // base - начало вершин в памяти или nullptr для смещений в привязанном VBO
+    static void enableVertexArrays(const float* base) {
+        const GLsizei stride = MESH_VERTEX_FLOATS * sizeof(float);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glVertexPointer(3, GL_FLOAT, stride, floatOffset(base, 0));
+        glNormalPointer(GL_FLOAT, stride, floatOffset(base, 3));
+    }
+
+    static void disableVertexArrays() {
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glDisableClientState(GL_NORMAL_ARRAY);
+    }
+
+public:
+    MeshBuffer() : indexCount(0), vertexCount(0), vertexBuffer(0), indexBuffer(0), vertexArray(0) {}
+
+    // Повторная загрузка переписывает уже созданные буферы
+    void upload(const MeshData& mesh) {
+        const GLCapabilities& capabilities = glCapabilities();
+        indexCount = static_cast<GLsizei>(mesh.indices.size());
+        vertexCount = mesh.vertexCount();
+
+        if (!capabilities.vertexBuffers) {
+            vertices = mesh.vertices;
+            indices = mesh.indices;
+            return;
+        }
+
+        bool created = vertexBuffer == 0;
+        if (created) {
+            glGenBuffers(1, &vertexBuffer);
+            glGenBuffers(1, &indexBuffer);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(float), mesh.vertices.data(), GL_STATIC_DRAW);
+
+        if (created && capabilities.vertexArrays) {
+            // VAO запоминает указатели и привязанный буфер индексов
+            glGenVertexArrays(1, &vertexArray);
+            glBindVertexArray(vertexArray);
+            enableVertexArrays(nullptr);
+        }
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(uint32_t), mesh.indices.data(), GL_STATIC_DRAW);
+
+        if (vertexArray) glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    void release() {
+        if (vertexBuffer) glDeleteBuffers(1, &vertexBuffer);
+        if (indexBuffer) glDeleteBuffers(1, &indexBuffer);
+        if (vertexArray) glDeleteVertexArrays(1, &vertexArray);
+        vertexBuffer = indexBuffer = vertexArray = 0;
+        std::vector<float>().swap(vertices);
+        std::vector<uint32_t>().swap(indices);
+        indexCount = 0;
+        vertexCount = 0;
+    }
+
+    GLsizei getIndexCount() const { return indexCount; }
+    size_t getVertexCount() const { return vertexCount; }
+
+    // Привязка буферов (или массивов) меша. Между bind и unbind можно
+    // рисовать его много раз - например, с разными матрицами
+    void bind() const {
+        if (vertexArray) {
+            glBindVertexArray(vertexArray);
+        }
+        else if (vertexBuffer) {
+            glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+            enableVertexArrays(nullptr);
+        }
+        else {
+            enableVertexArrays(vertices.data());
+        }
+    }
+
+    // Состояние массивов сбрасывается: остальная сцена (glutSolidSphere,
+    // glBegin) рисуется по-старому
+    void unbind() const {
+        if (vertexArray) {
+            glBindVertexArray(0);
+            return;
+        }
+        disableVertexArrays();
+        if (vertexBuffer) {
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        }
+    }
+
+    void drawBound() const {
+        if (indexCount == 0) return;
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, vertexBuffer ? nullptr : indices.data());
+    }
+
+    // Только с буферами в видеокарте (glCapabilities().instancing)
+    void drawBoundInstanced(GLsizei instances) const {
+        if (indexCount == 0 || instances == 0) return;
+        glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, nullptr, instances);
+    }
+
+    // Один indexed-вызов
+    void draw() const {
+        if (indexCount == 0) return;
+        bind();
+        drawBound();
+        unbind();
+    }
+};
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef MESHDATA_H
+#define MESHDATA_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Вершина: позиция и нормаль подряд (x y z nx ny nz)
+const int MESH_VERTEX_FLOATS = 6;
+
+// Треугольный меш в памяти, без OpenGL: его собирают загрузчик моделей и
+// построитель стен, а MeshBuffer (meshBuffer.h) переносит в видеокарту
+struct MeshData {
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+
+    // Ёмкость остаётся: повторная сборка в тот же MeshData не выделяет память
+    void clear() {
+        vertices.clear();
+        indices.clear();
+    }
+
+    size_t vertexCount() const { return vertices.size() / MESH_VERTEX_FLOATS; }
+    size_t triangleCount() const { return indices.size() / 3; }
+
+    uint32_t addVertex(float x, float y, float z, float nx, float ny, float nz) {
+        uint32_t index = static_cast<uint32_t>(vertexCount());
+        const float vertex[MESH_VERTEX_FLOATS] = { x, y, z, nx, ny, nz };
+        vertices.insert(vertices.end(), vertex, vertex + MESH_VERTEX_FLOATS);
+        return index;
+    }
+
+    void addTriangle(uint32_t a, uint32_t b, uint32_t c) {
+        indices.push_back(a);
+        indices.push_back(b);
+        indices.push_back(c);
+    }
+
+    // Четырёхугольник с общей нормалью; углы против часовой стрелки, если
+    // смотреть навстречу нормали, как в glBegin(GL_QUADS)
+    void addQuad(const float corners[4][3], float nx, float ny, float nz) {
+        uint32_t first = 0;
+        for (int k = 0; k < 4; k++) {
+            uint32_t index = addVertex(corners[k][0], corners[k][1], corners[k][2], nx, ny, nz);
+            if (k == 0) first = index;
+        }
+        addTriangle(first, first + 1, first + 2);
+        addTriangle(first, first + 2, first + 3);
+    }
+};
+
+// Сфера радиуса 1 с центром в нуле, разбитая как glutSolidSphere: slices
+// долей по кругу и stacks поясов от полюса до полюса. Нормаль совпадает с
+// позицией, поэтому при glScalef нужен GL_NORMALIZE (он включён в main).
+inline void appendSphere(MeshData& out, int slices, int stacks) {
+    const float pi = 3.14159265358979f;
+    uint32_t first = static_cast<uint32_t>(out.vertexCount());
+    for (int stack = 0; stack <= stacks; stack++) {
+        float polar = pi * stack / stacks;
+        float ring = std::sin(polar), z = std::cos(polar);
+        for (int slice = 0; slice <= slices; slice++) {
+            float azimuth = 2.0f * pi * slice / slices;
+            float x = ring * std::cos(azimuth), y = ring * std::sin(azimuth);
+            out.addVertex(x, y, z, x, y, z);
+        }
+    }
+    const uint32_t row = static_cast<uint32_t>(slices + 1);
+    for (int stack = 0; stack < stacks; stack++) {
+        for (int slice = 0; slice < slices; slice++) {
+            uint32_t a = first + stack * row + slice, b = a + row;
+            // Вырожденные треугольники у полюсов не рисуем
+            if (stack > 0) out.addTriangle(a, b, a + 1);
+            if (stack < stacks - 1) out.addTriangle(a + 1, b, b + 1);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,217 @@
+#ifndef MODEL3DS_H
+#define MODEL3DS_H
+
+#include "meshBuffer.h"
+#include "glStateCache.h"
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <assimp/mesh.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Вспомогательные функции для работы с матрицами
+inline aiMatrix4x4 multiplyMatrices(const aiMatrix4x4& a, const aiMatrix4x4& b) {
+    aiMatrix4x4 result;
+    for (unsigned int i = 0; i < 4; ++i) {
+        for (unsigned int j = 0; j < 4; ++j) {
+            result[i][j] = 0.0f;
+            for (unsigned int k = 0; k < 4; ++k) {
+                result[i][j] += a[i][k] * b[k][j];
+            }
+        }
+    }
+    return result;
+}
+
+inline aiVector3D transformVector(const aiMatrix4x4& matrix, const aiVector3D& vector) {
+    aiVector3D result;
+    result.x = matrix.a1 * vector.x + matrix.a2 * vector.y + matrix.a3 * vector.z + matrix.a4;
+    result.y = matrix.b1 * vector.x + matrix.b2 * vector.y + matrix.b3 * vector.z + matrix.b4;
+    result.z = matrix.c1 * vector.x + matrix.c2 * vector.y + matrix.c3 * vector.z + matrix.c4;
+    return result;
+}
+
+// Меш модели: геометрия (до upload - в памяти, после - в видеокарте) и
+// материал из файла
+struct ModelMesh {
+    MeshData data;
+    MeshBuffer buffer;
+
+    // Флаги - нашёлся ли цвет (как раньше с aiGetMaterialColor)
+    bool hasMaterial;
+    bool hasDiffuse;
+    bool hasAmbient;
+    GLfloat diffuse[4];
+    GLfloat ambient[4];
+};
+
+// Упрощенный класс для загрузки 3D моделей. Assimp нужен только при
+// загрузке: меши сразу переводятся в массивы вершин и индексов, сцена
+// освобождается, а upload() переносит массивы в буферы видеокарты
+class SimpleModel3DS {
+private:
+    std::vector<ModelMesh> meshes;
+    unsigned int materialCount;
+    bool loaded;
+    bool uploaded;
+    float scaleFactor;
+
+public:
+    SimpleModel3DS() : materialCount(0), loaded(false), uploaded(false), scaleFactor(1.0f) {}
+
+    // Метод для загрузки модели; контекст OpenGL не нужен
+    bool loadFromFile(const std::string& filename) {
+        release();
+        Assimp::Importer importer;
+        const aiScene* scene = importer.ReadFile(filename,
+            aiProcess_Triangulate |
+            aiProcess_GenSmoothNormals |
+            aiProcess_FlipUVs |
+            aiProcess_JoinIdenticalVertices);
+
+        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+            std::cerr << "Assimp error: " << importer.GetErrorString() << std::endl;
+            return false;
+        }
+
+        meshes.resize(scene->mNumMeshes);
+        for (unsigned int m = 0; m < scene->mNumMeshes; m++) {
+            convertMesh(scene, scene->mMeshes[m], meshes[m]);
+        }
+        materialCount = scene->mNumMaterials;
+        calculateSimpleScale(scene);
+
+        // Сцена больше не нужна: всё нужное для отрисовки уже скопировано
+        importer.FreeScene();
+        loaded = true;
+        return true;
+    }
+
+    // Переносит меши в видеокарту и освобождает копии в памяти. Вызывается
+    // один раз после loadFromFile, когда уже есть контекст; буферы мешей
+    // есть только у загруженной так модели.
+    void upload() {
+        if (!loaded || uploaded) return;
+        for (ModelMesh& mesh : meshes) {
+            mesh.buffer.upload(mesh.data);
+            mesh.data = MeshData();
+        }
+        uploaded = true;
+    }
+
+    // Удаляет буферы видеокарты; вызывать, пока контекст ещё жив
+    void release() {
+        for (ModelMesh& mesh : meshes) {
+            mesh.buffer.release();
+        }
+        meshes.clear();
+        materialCount = 0;
+        loaded = false;
+        uploaded = false;
+    }
+
+    unsigned int getMeshCount() const { return static_cast<unsigned int>(meshes.size()); }
+    unsigned int getMaterialCount() const { return materialCount; }
+
+    float getScale() const { return scaleFactor; }
+
+    // Буфер меша m (после upload); рисуется в масштабе getScale()
+    const MeshBuffer& getMeshBuffer(unsigned int m) const { return meshes[m].buffer; }
+
+    // Материал меша m из файла поверх base. Блик у таких мешей приглушён,
+    // чтобы глаза не выглядели как глянцевый пластик; меш без материала
+    // рисуется с base.
+    GLMaterial getMeshMaterial(unsigned int m, const GLMaterial& base) const {
+        const ModelMesh& mesh = meshes[m];
+        GLMaterial material = base;
+        if (!mesh.hasMaterial) return material;
+        const GLfloat dimSpecular[] = { 0.1f, 0.1f, 0.1f, 1.0f };
+        std::copy(dimSpecular, dimSpecular + 4, material.specular);
+        material.shininess = 10.0f;
+        if (mesh.hasDiffuse) std::copy(mesh.diffuse, mesh.diffuse + 4, material.diffuse);
+        if (mesh.hasAmbient) std::copy(mesh.ambient, mesh.ambient + 4, material.ambient);
+        return material;
+    }
+
+    // Тонированный материал тела (меш 0) - так красятся призраки: фоновый
+    // цвет темнее для глубины, яркий блик
+    static GLMaterial tintMaterial(GLfloat r, GLfloat g, GLfloat b) {
+        GLMaterial material = {
+            { r * 0.4f, g * 0.4f, b * 0.4f, 1.0f },
+            { r, g, b, 1.0f },
+            { 0.8f, 0.8f, 0.8f, 1.0f },
+            32.0f
+        };
+        return material;
+    }
+
+private:
+    static void convertMesh(const aiScene* scene, const aiMesh* source, ModelMesh& mesh) {
+        MeshData& data = mesh.data;
+        data.clear();
+        data.vertices.reserve(static_cast<size_t>(source->mNumVertices) * MESH_VERTEX_FLOATS);
+        for (unsigned int i = 0; i < source->mNumVertices; i++) {
+            const aiVector3D& position = source->mVertices[i];
+            // Без нормалей раньше действовала последняя заданная; здесь - "вверх"
+            const aiVector3D normal = source->HasNormals() ? source->mNormals[i] : aiVector3D(0.0f, 1.0f, 0.0f);
+            data.addVertex(position.x, position.y, position.z, normal.x, normal.y, normal.z);
+        }
+
+        // После aiProcess_Triangulate остаются треугольники, а также точки и
+        // линии, которые glBegin(GL_TRIANGLES) всё равно не рисовал целиком
+        data.indices.reserve(static_cast<size_t>(source->mNumFaces) * 3);
+        for (unsigned int i = 0; i < source->mNumFaces; i++) {
+            const aiFace& face = source->mFaces[i];
+            if (face.mNumIndices != 3) continue;
+            data.addTriangle(face.mIndices[0], face.mIndices[1], face.mIndices[2]);
+        }
+
+        mesh.hasMaterial = source->mMaterialIndex < scene->mNumMaterials;
+        mesh.hasDiffuse = false;
+        mesh.hasAmbient = false;
+        if (mesh.hasMaterial) {
+            const aiMaterial* material = scene->mMaterials[source->mMaterialIndex];
+            aiColor4D color;
+            if (aiGetMaterialColor(material, AI_MATKEY_COLOR_DIFFUSE, &color) == AI_SUCCESS) {
+                mesh.hasDiffuse = true;
+                copyColor(color, mesh.diffuse);
+            }
+            if (aiGetMaterialColor(material, AI_MATKEY_COLOR_AMBIENT, &color) == AI_SUCCESS) {
+                mesh.hasAmbient = true;
+                copyColor(color, mesh.ambient);
+            }
+        }
+    }
+
+    static void copyColor(const aiColor4D& color, GLfloat* target) {
+        target[0] = color.r;
+        target[1] = color.g;
+        target[2] = color.b;
+        target[3] = color.a;
+    }
+
+    void calculateSimpleScale(const aiScene* scene) {
+        // Простое вычисление масштаба
+        if (scene->mNumMeshes > 0) {
+            const aiMesh* mesh = scene->mMeshes[0];
+            float maxSize = 0.0f;
+
+            for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
+                const aiVector3D& vertex = mesh->mVertices[i];
+                maxSize = std::max(maxSize, std::abs(vertex.x));
+                maxSize = std::max(maxSize, std::abs(vertex.y));
+                maxSize = std::max(maxSize, std::abs(vertex.z));
+            }
+
+            if (maxSize > 0.0f) {
+                scaleFactor = 1.0f / maxSize;
+            }
+        }
+    }
+};
+
+#endif
@@ -2,39 +2,72 @@
 #define PACMAN_H
 
 #include "gameMap.h"
-#include <cmath>
+#include "fixed.h"
+#include "gameState.h"
+#include "stateHash.h"
+
+// Рот открывается и закрывается на MOUTH_STEP за тик; цикл из MOUTH_PERIOD
+// тиков, угол от 0 до MOUTH_STEP * MOUTH_PERIOD / 2 (в долях FIXED_ONE)
+const int MOUTH_STEP = FIXED_ONE * 8 / 100;
+const int MOUTH_PERIOD = 26;
 
 class Pacman {
 private:
-    float x, y;
-    float startX, startY;
+    int x, y;           // в единицах FIXED_ONE
+    int startX, startY;
     int dx, dy;
     int nextDx, nextDy;
-    float speed;
+    int speed;          // единиц FIXED_ONE за тик
     int lives;
-    float mouthAngle;
-    float mouthSpeed;
-    bool mouthOpening;
-    float rotationY;
+    int mouthTick;      // фаза анимации рта, 0..MOUTH_PERIOD-1
+    int rotationY;      // градусы
+    uint64_t hashSum;   // сумма stateFieldKey(поле) * значение по всем полям
+
+    // Номера полей для stateFieldKey
+    enum HashField {
+        HASH_X, HASH_Y, HASH_START_X, HASH_START_Y, HASH_DX, HASH_DY,
+        HASH_NEXT_DX, HASH_NEXT_DY, HASH_SPEED, HASH_LIVES, HASH_MOUTH, HASH_ROTATION
+    };
+
+    // Все поля пишутся через set: хеш поправляется на разность значений.
+    // Ключ поля - параметр шаблона, чтобы считался при компиляции.
+    template <HashField F>
+    void set(int& field, int value) {
+        constexpr uint64_t fieldKey = stateFieldKey(STATE_KEYS_PACMAN + F);
+        hashSum += fieldKey * (static_cast<uint64_t>(value) - static_cast<uint64_t>(field));
+        field = value;
+    }
+
+    // Хеш с нуля - после записи полей напрямую
+    void rehash() {
+        const int fields[] = { x, y, startX, startY, dx, dy, nextDx, nextDy, speed, lives, mouthTick, rotationY };
+        hashSum = 0;
+        for (int f = 0; f < HASH_ROTATION + 1; f++) {
+            hashSum += stateFieldKey(STATE_KEYS_PACMAN + f) * static_cast<uint64_t>(fields[f]);
+        }
+    }
+
+    void setRotation(int ndx, int ndy) {
+        if (ndx == 1) set<HASH_ROTATION>(rotationY, 0);         // Вправо
+        else if (ndx == -1) set<HASH_ROTATION>(rotationY, 180); // Влево
+        else if (ndy == 1) set<HASH_ROTATION>(rotationY, 90);   // Вверх
+        else if (ndy == -1) set<HASH_ROTATION>(rotationY, 270); // Вниз
+    }
 
 public:
-    Pacman(float startX = 0, float startY = 0)
+    // Стартовая позиция в единицах FIXED_ONE
+    Pacman(int startX = 0, int startY = 0)
         : x(startX), y(startY), startX(startX), startY(startY),
         dx(0), dy(0), nextDx(0), nextDy(0),
-        speed(0.1f), lives(1),
-        mouthAngle(0.0f), mouthSpeed(0.08f), mouthOpening(true),
-        rotationY(0) {
+        speed(FIXED_ONE / 10), lives(1),
+        mouthTick(0), rotationY(0) {
+        rehash();
     }
 
     void setDirection(int ndx, int ndy) {
-        nextDx = ndx;
-        nextDy = ndy;
-
-        
-        if (ndx == 1) rotationY = 0;      // Вправо
-        else if (ndx == -1) rotationY = 180; // Влево
-        else if (ndy == 1) rotationY = 90;   // Вверх
-        else if (ndy == -1) rotationY = 270; // Вниз
+        set<HASH_NEXT_DX>(nextDx, ndx);
+        set<HASH_NEXT_DY>(nextDy, ndy);
+        setRotation(ndx, ndy);
     }
 
     void update(const GameMap& map) {
@@ -43,67 +76,70 @@ public:
 
         // Всегда пытаемся сменить направление (буферизация ввода)
         if ((nextDx != 0 || nextDy != 0)) {
-            int testX = static_cast<int>(std::round(x)) + nextDx;
-            int testY = static_cast<int>(std::round(y)) + nextDy;
-
-            if (map.canMove(testX, testY)) {
-                dx = nextDx;
-                dy = nextDy;
-
-                
-                if (dx == 1) rotationY = 0;      // Вправо
-                else if (dx == -1) rotationY = 180; // Влево
-                else if (dy == 1) rotationY = 90;   // Вверх
-                else if (dy == -1) rotationY = 270; // Вниз
+            int tileX = fixedRoundToTile(x);
+            int tileY = fixedRoundToTile(y);
+
+            if (map.canStep(tileX, tileY, nextDx, nextDy)) {
+                set<HASH_DX>(dx, nextDx);
+                set<HASH_DY>(dy, nextDy);
+                setRotation(dx, dy);
             }
-            nextDx = 0;
-            nextDy = 0;
+            set<HASH_NEXT_DX>(nextDx, 0);
+            set<HASH_NEXT_DY>(nextDy, 0);
         }
 
         // Движение
         if (dx != 0 || dy != 0) {
-            float newX = x + dx * speed;
-            float newY = y + dy * speed;
+            int newX = x + dx * speed;
+            int newY = y + dy * speed;
 
-            int currentCellX = static_cast<int>(std::round(x));
-            int currentCellY = static_cast<int>(std::round(y));
-            int targetCellX = static_cast<int>(std::round(newX));
-            int targetCellY = static_cast<int>(std::round(newY));
+            int currentCellX = fixedRoundToTile(x);
+            int currentCellY = fixedRoundToTile(y);
+            int targetCellX = fixedRoundToTile(newX);
+            int targetCellY = fixedRoundToTile(newY);
 
             if ((currentCellX == targetCellX && currentCellY == targetCellY) ||
-                map.canMove(targetCellX, targetCellY)) {
-                x = newX;
-                y = newY;
+                map.canStep(currentCellX, currentCellY, targetCellX - currentCellX, targetCellY - currentCellY)) {
+                set<HASH_X>(x, newX);
+                set<HASH_Y>(y, newY);
             }
             else {
-                dx = 0;
-                dy = 0;
-                x = std::round(x);
-                y = std::round(y);
+                set<HASH_DX>(dx, 0);
+                set<HASH_DY>(dy, 0);
+                set<HASH_X>(x, fixedFromTile(currentCellX));
+                set<HASH_Y>(y, fixedFromTile(currentCellY));
             }
         }
     }
 
     void updateMouthAnimation() {
-        if (mouthOpening) {
-            mouthAngle += mouthSpeed;
-            if (mouthAngle >= 1.0f) {
-                mouthOpening = false;
-            }
-        }
-        else {
-            mouthAngle -= mouthSpeed;
-            if (mouthAngle <= 0.05f) {
-                mouthOpening = true;
-            }
-        }
+        set<HASH_MOUTH>(mouthTick, (mouthTick + 1) % MOUTH_PERIOD);
+    }
+
+    // Через сколько тиков update() сделает что-то кроме равномерного
+    // движения и анимации рта: попытка поворота или переход в соседнюю
+    // клетку (проверка стены). NO_EVENT - стоит на месте. Монеты под
+    // Пакманом проверяет Game.
+    int ticksToNextEvent() const {
+        if (nextDx != 0 || nextDy != 0) return 1;
+        if (dx != 0) return fixedStepsInTile(x, dx, speed) + 1;
+        if (dy != 0) return fixedStepsInTile(y, dy, speed) + 1;
+        return NO_EVENT;
+    }
+
+    // ticks вызовов update() разом; только для ticks < ticksToNextEvent()
+    void coast(int ticks) {
+        set<HASH_MOUTH>(mouthTick, (mouthTick + ticks) % MOUTH_PERIOD);
+        set<HASH_X>(x, x + dx * speed * ticks);
+        set<HASH_Y>(y, y + dy * speed * ticks);
     }
 
     void die() {
-        lives--;
+        set<HASH_LIVES>(lives, lives - 1);
     }
 
-    void resetPosition(float sx, float sy) {
+    // Позиция в единицах FIXED_ONE
+    void resetPosition(int sx, int sy) {
         x = sx;
         y = sy;
         startX = sx;
@@ -112,24 +148,68 @@ public:
         dy = 0;
         nextDx = 0;
         nextDy = 0;
-        mouthAngle = 0.0f;
-        mouthOpening = true;
+        mouthTick = 0;
         rotationY = 0;
+        rehash();
+    }
+
+    void saveState(PacmanState& out) const {
+        out.x = x;
+        out.y = y;
+        out.startX = startX;
+        out.startY = startY;
+        out.dx = dx;
+        out.dy = dy;
+        out.nextDx = nextDx;
+        out.nextDy = nextDy;
+        out.speed = speed;
+        out.lives = lives;
+        out.mouthTick = mouthTick;
+        out.rotationY = rotationY;
+    }
+
+    void loadState(const PacmanState& in) {
+        x = in.x;
+        y = in.y;
+        startX = in.startX;
+        startY = in.startY;
+        dx = in.dx;
+        dy = in.dy;
+        nextDx = in.nextDx;
+        nextDy = in.nextDy;
+        speed = in.speed;
+        lives = in.lives;
+        mouthTick = in.mouthTick;
+        rotationY = in.rotationY;
+        rehash();
     }
 
     bool isAlive() const { return lives > 0; }
-    float getX() const { return x; }
-    float getY() const { return y; }
-    void setSpeed(float s) { speed = s; }
+    int getLives() const { return lives; }
+    int getFixedX() const { return x; }
+    int getFixedY() const { return y; }
+    void setSpeed(int s) { set<HASH_SPEED>(speed, s); }
+
+    // Линейный хеш всех полей, поправляется при каждой записи; для
+    // Game::stateHash()
+    uint64_t getHashSum() const { return hashSum; }
+
+    // Позиция в клетках - для отрисовки
+    float getX() const { return fixedToFloat(x); }
+    float getY() const { return fixedToFloat(y); }
 
     // Геттеры для анимации рта и направления
-    float getMouthAngle() const { return mouthAngle; }
+    float getMouthAngle() const {
+        int phase = mouthTick <= MOUTH_PERIOD / 2 ? mouthTick : MOUTH_PERIOD - mouthTick;
+        return fixedToFloat(phase * MOUTH_STEP);
+    }
     int getDirectionX() const { return dx; }
     int getDirectionY() const { return dy; }
 
     // Геттеры для 3D
-    float getRotationY() const { return rotationY; }
-    float getSpeed() const { return speed; }
+    float getRotationY() const { return static_cast<float>(rotationY); }
+    float getSpeed() const { return fixedToFloat(speed); }
+    int getFixedSpeed() const { return speed; }
 };
 
 #endif
\ No newline at end of file
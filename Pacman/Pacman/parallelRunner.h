@@ -0,0 +1,107 @@
+#ifndef PARALLELRUNNER_H
+#define PARALLELRUNNER_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Раздаёт независимые задачи [0, count) по всем ядрам с кражей работы.
+// Каждый поток получает свой отрезок индексов и берёт задачи с его начала;
+// освободившийся поток отбирает у соседа половину оставшегося хвоста.
+// Задачи (партии, BFS от клеток) занимают очень разное время, поэтому
+// статичного деления мало.
+class ParallelRunner {
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    int threadCount;
+
+    static bool popLocal(WorkQueue& queue, size_t& index) {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.begin >= queue.end) return false;
+        index = queue.begin++;
+        return true;
+    }
+
+    static bool steal(WorkQueue& victim, WorkQueue& thief) {
+        size_t stolenBegin, stolenEnd;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.begin >= victim.end) return false;
+            size_t remaining = victim.end - victim.begin;
+            stolenEnd = victim.end;
+            stolenBegin = victim.end - (remaining + 1) / 2;
+            victim.end = stolenBegin;
+        }
+        std::lock_guard<std::mutex> lock(thief.mutex);
+        thief.begin = stolenBegin;
+        thief.end = stolenEnd;
+        return true;
+    }
+
+    template <typename Task>
+    static void workerLoop(std::vector<std::unique_ptr<WorkQueue>>& queues, size_t self, Task& task) {
+        size_t index;
+        for (;;) {
+            while (popLocal(*queues[self], index)) {
+                task(index);
+            }
+
+            // Своя очередь пуста - ищем, у кого украсть
+            bool stolen = false;
+            for (size_t k = 1; k < queues.size() && !stolen; k++) {
+                stolen = steal(*queues[(self + k) % queues.size()], *queues[self]);
+            }
+            if (!stolen) return; // новых задач не появляется, можно выходить
+        }
+    }
+
+public:
+    // threads <= 0 - по числу аппаратных потоков
+    explicit ParallelRunner(int threads = 0) : threadCount(threads) {
+        if (threadCount <= 0) {
+            threadCount = static_cast<int>(std::thread::hardware_concurrency());
+            if (threadCount <= 0) threadCount = 1;
+        }
+    }
+
+    int getThreadCount() const { return threadCount; }
+
+    // Вызывает task(i) для каждого i из [0, count). Порядок выполнения не задан,
+    // поэтому задача должна писать только в свой слот результата.
+    template <typename Task>
+    void run(size_t count, Task task) {
+        size_t workers = static_cast<size_t>(threadCount);
+        if (workers > count) workers = count;
+        if (workers <= 1) {
+            for (size_t i = 0; i < count; i++) task(i);
+            return;
+        }
+
+        std::vector<std::unique_ptr<WorkQueue>> queues;
+        queues.reserve(workers);
+        for (size_t w = 0; w < workers; w++) {
+            queues.emplace_back(new WorkQueue());
+            queues[w]->begin = count * w / workers;
+            queues[w]->end = count * (w + 1) / workers;
+        }
+
+        std::vector<std::thread> threads;
+        threads.reserve(workers - 1);
+        for (size_t w = 1; w < workers; w++) {
+            threads.emplace_back([&queues, &task, w]() { workerLoop(queues, w, task); });
+        }
+        workerLoop(queues, 0, task);
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+};
+
+#endif
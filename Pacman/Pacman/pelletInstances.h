@@ -0,0 +1,141 @@
+#ifndef PELLETINSTANCES_H
+#define PELLETINSTANCES_H
+
+#include "gameMap.h"
+#include "gameEvents.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum PelletKind {
+    PELLET_COIN,
+    PELLET_POWER_POINT,
+    PELLET_KINDS
+};
+
+// Где стоят пеллеты: клетка (j, i) - в (j * cellSize, height, (mapHeight - i) * cellSize)
+struct PelletLayout {
+    float cellSize;
+    float heights[PELLET_KINDS];
+};
+
+// Сколько экземпляров можно переписать между двумя flush; больше - значит,
+// дешевле перезалить слой целиком (так список и не выделяет память)
+const size_t PELLET_DIRTY_LIMIT = 64;
+
+// Позиции оставшихся монет и энергетиков плотными массивами - буфер
+// экземпляров для отрисовки без OpenGL. Съеденный пеллет (события
+// EVENT_COIN_EATEN и EVENT_POWER_MODE_STARTED) убирается за O(1): на его
+// место переезжает последний, и переписать в видеокарте нужно только этот
+// один слот (getDirty). Свой хеш Зобриста сверяется с хешем слоёв карты:
+// если события потерялись или карта сменилась целиком (рестарт, уровень,
+// перемотка записи), sync собирает список заново.
+class PelletInstances : public GameEventListener {
+private:
+    struct Layer {
+        std::vector<float> positions; // x y z на экземпляр
+        std::vector<int32_t> cells;   // индекс клетки в слое монет для каждого экземпляра
+        std::vector<int32_t> dirty;   // слоты, переписанные после clearDirty
+        bool overflow;                // грязных слишком много - лучше залить весь слой
+        uint64_t hash;
+    };
+
+    Layer layers[PELLET_KINDS];
+    // Клетка -> слот в своём слое или -1; монета и энергетик в одной клетке
+    // не лежат (placePowerPoint убирает монету), поэтому таблица общая
+    std::vector<int32_t> slots;
+    const GameMap* map;
+    PelletLayout layout;
+    uint32_t wallVersion;
+
+    const CoinLayer& mapLayer(int kind) const {
+        return kind == PELLET_COIN ? map->getCoins() : map->getPowerPoints();
+    }
+
+    void remove(int kind, int x, int y) {
+        if (!map || x < 0 || y < 0 || x >= map->getWidth() || y >= map->getHeight()) return;
+        int cell = (y + 1) * map->getStride() + (x + 1);
+        int32_t slot = slots[cell];
+        Layer& layer = layers[kind];
+        if (slot < 0 || layer.cells[slot] != cell) return;
+
+        int32_t last = static_cast<int32_t>(layer.cells.size()) - 1;
+        if (slot != last) {
+            for (int k = 0; k < 3; k++) layer.positions[slot * 3 + k] = layer.positions[last * 3 + k];
+            layer.cells[slot] = layer.cells[last];
+            slots[layer.cells[slot]] = slot;
+            if (layer.dirty.size() < PELLET_DIRTY_LIMIT) layer.dirty.push_back(slot);
+            else layer.overflow = true;
+        }
+        layer.positions.resize(static_cast<size_t>(last) * 3);
+        layer.cells.pop_back();
+        slots[cell] = -1;
+        layer.hash ^= mapLayer(kind).key(cell);
+    }
+
+public:
+    explicit PelletInstances(const PelletLayout& layout) : map(nullptr), layout(layout), wallVersion(0) {
+        for (Layer& layer : layers) {
+            layer.dirty.reserve(PELLET_DIRTY_LIMIT);
+            layer.overflow = false;
+            layer.hash = 0;
+        }
+    }
+
+    // Полная сборка по карте; ёмкость массивов сохраняется между сборками
+    void rebuild(const GameMap& source) {
+        map = &source;
+        wallVersion = source.getWallVersion();
+        slots.assign(source.getCoins().wordCount() * 64, -1);
+        const int stride = source.getStride();
+        const int height = source.getHeight();
+
+        for (int kind = 0; kind < PELLET_KINDS; kind++) {
+            Layer& layer = layers[kind];
+            layer.positions.clear();
+            layer.cells.clear();
+            layer.dirty.clear();
+            layer.overflow = false;
+            const CoinLayer& bits = mapLayer(kind);
+            layer.hash = bits.getHash();
+            const float y = layout.heights[kind];
+            bits.forEach([&](int cell) {
+                int j = cell % stride - 1, i = cell / stride - 1;
+                slots[cell] = static_cast<int32_t>(layer.cells.size());
+                layer.cells.push_back(cell);
+                layer.positions.push_back(j * layout.cellSize);
+                layer.positions.push_back(y);
+                layer.positions.push_back((height - i) * layout.cellSize);
+            });
+        }
+    }
+
+    // true, если список пришлось собрать заново (тогда слои заливаются целиком)
+    bool sync(const GameMap& source) {
+        bool stale = map != &source || wallVersion != source.getWallVersion();
+        for (int kind = 0; kind < PELLET_KINDS && !stale; kind++) {
+            stale = layers[kind].hash != mapLayer(kind).getHash();
+        }
+        if (stale) rebuild(source);
+        return stale;
+    }
+
+    void onGameEvent(const GameEvent& event) override {
+        if (event.type == EVENT_COIN_EATEN) remove(PELLET_COIN, event.x, event.y);
+        else if (event.type == EVENT_POWER_MODE_STARTED) remove(PELLET_POWER_POINT, event.x, event.y);
+    }
+
+    size_t count(int kind) const { return layers[kind].cells.size(); }
+    const float* positions(int kind) const { return layers[kind].positions.data(); }
+
+    // Слоты, чьи позиции изменились; среди них могут быть повторы и слоты
+    // за count() - их уже нет, переписывать их не нужно
+    const std::vector<int32_t>& getDirty(int kind) const { return layers[kind].dirty; }
+    bool isOverflowed(int kind) const { return layers[kind].overflow; }
+    void clearDirty(int kind) {
+        layers[kind].dirty.clear();
+        layers[kind].overflow = false;
+    }
+};
+
+#endif
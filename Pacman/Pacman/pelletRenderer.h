@@ -0,0 +1,160 @@
+#ifndef PELLETRENDERER_H
+#define PELLETRENDERER_H
+
+#include "meshBuffer.h"
+#include "pelletInstances.h"
+#include "shaderProgram.h"
+#include <cstddef>
+#include <cstdint>
+
+// Фиксированное освещение OpenGL (положения источников, материал, без
+// прожекторов и локального наблюдателя - как в сцене) по вершинам, плюс
+// сдвиг экземпляра: так пеллеты с экземплярами выглядят как раньше
+const char* const PELLET_VERTEX_SHADER =
+    "#version 120\n"
+    "attribute vec3 instanceOffset;\n"
+    "uniform float radius;\n"
+    "void main() {\n"
+    "    vec4 eye = gl_ModelViewMatrix * vec4(gl_Vertex.xyz * radius + instanceOffset, 1.0);\n"
+    "    vec3 normal = normalize(gl_NormalMatrix * gl_Normal);\n"
+    "    vec4 color = gl_FrontLightModelProduct.sceneColor;\n"
+    "    for (int i = 0; i < 2; i++) {\n"
+    "        vec3 toLight = gl_LightSource[i].position.xyz - eye.xyz * gl_LightSource[i].position.w;\n"
+    "        float distance = length(toLight);\n"
+    "        vec3 direction = toLight / distance;\n"
+    "        float attenuation = 1.0 / (gl_LightSource[i].constantAttenuation +\n"
+    "            gl_LightSource[i].linearAttenuation * distance +\n"
+    "            gl_LightSource[i].quadraticAttenuation * distance * distance);\n"
+    "        float diffuse = max(dot(normal, direction), 0.0);\n"
+    "        color += attenuation * (gl_FrontLightProduct[i].ambient + diffuse * gl_FrontLightProduct[i].diffuse);\n"
+    "        if (diffuse > 0.0) {\n"
+    "            vec3 halfVector = normalize(direction + vec3(0.0, 0.0, 1.0));\n"
+    "            float specular = pow(max(dot(normal, halfVector), 0.0), gl_FrontMaterial.shininess);\n"
+    "            color += attenuation * specular * gl_FrontLightProduct[i].specular;\n"
+    "        }\n"
+    "    }\n"
+    "    gl_FrontColor = vec4(clamp(color.rgb, 0.0, 1.0), gl_FrontMaterial.diffuse.a);\n"
+    "    gl_Position = gl_ProjectionMatrix * eye;\n"
+    "}\n";
+
+const char* const PELLET_FRAGMENT_SHADER =
+    "#version 120\n"
+    "void main() {\n"
+    "    gl_FragColor = gl_Color;\n"
+    "}\n";
+
+// Монеты и энергетики: одна общая сфера в видеокарте и по буферу позиций
+// на вид пеллета. С GL 3.3 каждый вид - один glDrawElementsInstanced, иначе
+// та же сфера рисуется по экземплярам без пересборки геометрии. Материал
+// ставит вызывающий, один раз на вид.
+class PelletRenderer {
+private:
+    PelletInstances instances;
+    MeshBuffer sphere;
+    GLuint program;
+    GLint offsetLocation;
+    GLint radiusLocation;
+    GLuint instanceBuffers[PELLET_KINDS];
+
+    void uploadLayer(int kind) {
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffers[kind]);
+        glBufferData(GL_ARRAY_BUFFER, instances.count(kind) * 3 * sizeof(float), instances.positions(kind), GL_DYNAMIC_DRAW);
+    }
+
+    // Только переехавшие слоты: по 12 байт на съеденный пеллет
+    void uploadDirty(int kind) {
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffers[kind]);
+        const float* positions = instances.positions(kind);
+        for (int32_t slot : instances.getDirty(kind)) {
+            if (static_cast<size_t>(slot) >= instances.count(kind)) continue;
+            glBufferSubData(GL_ARRAY_BUFFER, slot * 3 * sizeof(float), 3 * sizeof(float), positions + slot * 3);
+        }
+    }
+
+public:
+    explicit PelletRenderer(const PelletLayout& layout)
+        : instances(layout), program(0), offsetLocation(-1), radiusLocation(-1) {
+        instanceBuffers[PELLET_COIN] = instanceBuffers[PELLET_POWER_POINT] = 0;
+    }
+
+    // Нужен контекст (после initGLExtensions). Сфера - как у энергетика
+    // раньше (12 x 12); монеты рисуются ей же, только меньше.
+    void init() {
+        MeshData mesh;
+        appendSphere(mesh, 12, 12);
+        sphere.upload(mesh);
+
+        if (!glCapabilities().instancing) return;
+        program = buildShaderProgram(PELLET_VERTEX_SHADER, PELLET_FRAGMENT_SHADER);
+        if (!program) return;
+        offsetLocation = glGetAttribLocation(program, "instanceOffset");
+        radiusLocation = glGetUniformLocation(program, "radius");
+        if (offsetLocation < 0) {
+            glDeleteProgram(program);
+            program = 0;
+            return;
+        }
+        glGenBuffers(PELLET_KINDS, instanceBuffers);
+    }
+
+    bool isInstanced() const { return program != 0; }
+
+    // Сюда идут события игры: по ним съеденные пеллеты убираются из буферов
+    GameEventListener& getEventListener() { return instances; }
+
+    // Раз в кадр перед draw: подтягивает буферы к карте
+    void sync(const GameMap& map) {
+        bool rebuilt = instances.sync(map);
+        for (int kind = 0; kind < PELLET_KINDS; kind++) {
+            if (program) {
+                if (rebuilt || instances.isOverflowed(kind)) uploadLayer(kind);
+                else uploadDirty(kind);
+            }
+            instances.clearDirty(kind);
+        }
+        if (program) glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    size_t count(int kind) const { return instances.count(kind); }
+
+    void draw(int kind, float radius) const {
+        GLsizei count = static_cast<GLsizei>(instances.count(kind));
+        if (count == 0) return;
+
+        sphere.bind();
+        if (program) {
+            glUseProgram(program);
+            glUniform1f(radiusLocation, radius);
+            glBindBuffer(GL_ARRAY_BUFFER, instanceBuffers[kind]);
+            glEnableVertexAttribArray(offsetLocation);
+            glVertexAttribPointer(offsetLocation, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+            glVertexAttribDivisor(offsetLocation, 1);
+            sphere.drawBoundInstanced(count);
+            glVertexAttribDivisor(offsetLocation, 0);
+            glDisableVertexAttribArray(offsetLocation);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glUseProgram(0);
+        }
+        else {
+            const float* positions = instances.positions(kind);
+            for (GLsizei i = 0; i < count; i++) {
+                glPushMatrix();
+                glTranslatef(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]);
+                glScalef(radius, radius, radius);
+                sphere.drawBound();
+                glPopMatrix();
+            }
+        }
+        sphere.unbind();
+    }
+
+    void release() {
+        sphere.release();
+        if (instanceBuffers[PELLET_COIN]) glDeleteBuffers(PELLET_KINDS, instanceBuffers);
+        if (program) glDeleteProgram(program);
+        instanceBuffers[PELLET_COIN] = instanceBuffers[PELLET_POWER_POINT] = 0;
+        program = 0;
+    }
+};
+
+#endif
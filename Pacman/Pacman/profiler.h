@@ -0,0 +1,287 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Сколько последних зон помнит один поток (кольцо, старые затираются)
+const size_t PROFILE_BUFFER_RECORDS = 1 << 17;
+
+// Одна пройденная зона: имя (строковый литерал) и время в нс от старта
+struct ProfileRecord {
+    const char* name;
+    int64_t start;
+    int64_t end;
+};
+
+// Буфер одного потока. Пишет в него только свой поток, без блокировок;
+// читается при экспорте, когда потоки с зонами уже стоят. Когда поток
+// завершается, буфер со всеми записями остаётся и достаётся следующему
+// новому потоку: буферов столько, сколько потоков жило одновременно.
+struct ProfileBuffer {
+    std::vector<ProfileRecord> records;
+    uint64_t written; // всего записано; в кольце последние records.size()
+    int threadIndex;  // tid в трассе - номер буфера, а не потока
+    bool inUse;       // за буфер держится живой поток
+
+    uint64_t first() const { return written > records.size() ? written - records.size() : 0; }
+    const ProfileRecord& at(uint64_t index) const { return records[index % records.size()]; }
+};
+
+// Профайлер зон. Выключен по умолчанию: тогда зона - одна проверка флагов
+// без чтения часов. Включённый пишет зоны в кольца потоков и умеет
+// выгрузить их в формат chrome://tracing (trace_event) и сводной таблицей.
+class Profiler {
+private:
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ProfileBuffer>> buffers;
+        std::chrono::steady_clock::time_point epoch;
+        Registry() : epoch(std::chrono::steady_clock::now()) {}
+    };
+
+    static Registry& registry() {
+        static Registry instance;
+        return instance;
+    }
+
+    // Биты PROFILE_TIMING и PROFILE_ZONE_STACK; ноль - зоны ничего не делают
+    static std::atomic<unsigned>& modeFlags() {
+        static std::atomic<unsigned> flags(0);
+        return flags;
+    }
+
+    static void setMode(unsigned mode, bool enabled) {
+        if (enabled) modeFlags().fetch_or(mode, std::memory_order_relaxed);
+        else modeFlags().fetch_and(~mode, std::memory_order_relaxed);
+    }
+
+    // Буфер потока на время его жизни: деструктор thread_local отдаёт
+    // буфер обратно, и его берёт следующий поток (рабочие ParallelRunner
+    // создаются на каждый прогон)
+    struct ThreadBufferHolder {
+        ProfileBuffer* buffer = nullptr;
+        ~ThreadBufferHolder() {
+            if (!buffer) return;
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            buffer->inUse = false;
+        }
+    };
+
+    // Буфер текущего потока; берётся при первой зоне потока - свободный
+    // после завершившегося потока или новый
+    static ProfileBuffer& threadBuffer() {
+        static thread_local ThreadBufferHolder holder;
+        if (!holder.buffer) {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            for (auto& buffer : r.buffers) {
+                if (!buffer->inUse) {
+                    holder.buffer = buffer.get();
+                    break;
+                }
+            }
+            if (!holder.buffer) {
+                std::unique_ptr<ProfileBuffer> created(new ProfileBuffer());
+                created->records.resize(PROFILE_BUFFER_RECORDS);
+                created->written = 0;
+                created->threadIndex = static_cast<int>(r.buffers.size());
+                holder.buffer = created.get();
+                r.buffers.push_back(std::move(created));
+            }
+            holder.buffer->inUse = true;
+        }
+        return *holder.buffer;
+    }
+
+    static void writeEscaped(FILE* file, const char* text) {
+        for (; *text; text++) {
+            if (*text == '"' || *text == '\\') std::fputc('\\', file);
+            std::fputc(*text, file);
+        }
+    }
+
+public:
+    // Сколько буферов потоков заведено (по 3 МБ на каждый)
+    static size_t bufferCount() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        return r.buffers.size();
+    }
+
+    enum Mode : unsigned {
+        PROFILE_TIMING = 1,     // запись зон во времени
+        PROFILE_ZONE_STACK = 2  // только текущая зона потока (см. currentZone)
+    };
+
+    static unsigned activeModes() { return modeFlags().load(std::memory_order_relaxed); }
+    static bool isEnabled() { return (activeModes() & PROFILE_TIMING) != 0; }
+    static void setEnabled(bool enabled) {
+        registry(); // эпоха - до первой зоны
+        setMode(PROFILE_TIMING, enabled);
+    }
+
+    // Вести имя текущей зоны потока и без записи времени - для
+    // счётчиков, которым нужно знать, где они сработали
+    static void setZoneStack(bool enabled) { setMode(PROFILE_ZONE_STACK, enabled); }
+
+    // Самая вложенная открытая зона потока; nullptr вне зон или когда
+    // зоны не ведутся
+    static const char*& currentZone() {
+        static thread_local const char* zone = nullptr;
+        return zone;
+    }
+
+    // Наносекунды от создания профайлера
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - registry().epoch).count();
+    }
+
+    static void record(const char* name, int64_t start, int64_t end) {
+        ProfileBuffer& buffer = threadBuffer();
+        ProfileRecord& entry = buffer.records[buffer.written % PROFILE_BUFFER_RECORDS];
+        entry.name = name;
+        entry.start = start;
+        entry.end = end;
+        buffer.written++;
+    }
+
+    // Забыть записанное (буферы потоков остаются)
+    static void clear() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (auto& buffer : r.buffers) {
+            buffer->written = 0;
+        }
+    }
+
+    // JSON для chrome://tracing и Perfetto: зона - событие "X", tid -
+    // буфер в порядке создания (потоки, жившие друг после друга, делят tid)
+    static bool writeChromeTrace(const char* path) {
+        FILE* file = std::fopen(path, "w");
+        if (!file) return false;
+
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        std::fprintf(file, "{\"traceEvents\":[\n");
+        bool first = true;
+        for (const auto& buffer : r.buffers) {
+            for (uint64_t i = buffer->first(); i < buffer->written; i++) {
+                const ProfileRecord& entry = buffer->at(i);
+                std::fprintf(file, "%s{\"name\":\"", first ? "" : ",\n");
+                writeEscaped(file, entry.name);
+                std::fprintf(file, "\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    buffer->threadIndex, entry.start / 1000.0, (entry.end - entry.start) / 1000.0);
+                first = false;
+            }
+        }
+        std::fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+        return std::fclose(file) == 0;
+    }
+
+    // Таблица по зонам: число вызовов, сумма, среднее и максимум,
+    // по убыванию суммарного времени
+    static void printSummary(FILE* out) {
+        struct Totals {
+            uint64_t calls = 0;
+            int64_t total = 0;
+            int64_t longest = 0;
+        };
+        std::map<std::string, Totals> zones;
+        uint64_t overwritten = 0;
+        {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            for (const auto& buffer : r.buffers) {
+                overwritten += buffer->first();
+                for (uint64_t i = buffer->first(); i < buffer->written; i++) {
+                    const ProfileRecord& entry = buffer->at(i);
+                    Totals& totals = zones[entry.name];
+                    int64_t duration = entry.end - entry.start;
+                    totals.calls++;
+                    totals.total += duration;
+                    totals.longest = std::max(totals.longest, duration);
+                }
+            }
+        }
+
+        std::vector<std::pair<std::string, Totals>> sorted(zones.begin(), zones.end());
+        std::sort(sorted.begin(), sorted.end(),
+            [](const std::pair<std::string, Totals>& a, const std::pair<std::string, Totals>& b) {
+                return a.second.total > b.second.total;
+            });
+
+        std::fprintf(out, "%-24s %10s %12s %10s %10s\n", "zone", "calls", "total ms", "avg us", "max us");
+        for (const auto& zone : sorted) {
+            const Totals& t = zone.second;
+            std::fprintf(out, "%-24s %10llu %12.3f %10.3f %10.3f\n", zone.first.c_str(),
+                static_cast<unsigned long long>(t.calls), t.total / 1e6,
+                t.total / 1e3 / static_cast<double>(t.calls), t.longest / 1e3);
+        }
+        if (overwritten > 0) {
+            std::fprintf(out, "(only the latest zones of each thread; %llu older ones overwritten)\n",
+                static_cast<unsigned long long>(overwritten));
+        }
+    }
+};
+
+// Зона от конструктора до конца области видимости
+class ProfileZone {
+private:
+    const char* name;
+    const char* parent;
+    int64_t start;  // -1 - время не пишется
+    bool stacked;   // зона стала текущей для потока
+
+    void begin(unsigned modes) {
+        if (modes & Profiler::PROFILE_TIMING) start = Profiler::now();
+        if (modes & Profiler::PROFILE_ZONE_STACK) {
+            const char*& current = Profiler::currentZone();
+            parent = current;
+            current = name;
+            stacked = true;
+        }
+    }
+
+    void end() {
+        if (stacked) Profiler::currentZone() = parent;
+        if (start >= 0) Profiler::record(name, start, Profiler::now());
+    }
+
+public:
+    explicit ProfileZone(const char* zoneName)
+        : name(zoneName), parent(nullptr), start(-1), stacked(false) {
+        unsigned modes = Profiler::activeModes();
+        if (modes) begin(modes);
+    }
+
+    ~ProfileZone() {
+        if (start >= 0 || stacked) end();
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+};
+
+// PROFILE_ZONE("name") - зона до конца текущего блока. Имя должно жить
+// всю программу (строковый литерал). PACMAN_NO_PROFILER убирает зоны из
+// сборки совсем.
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#ifndef PACMAN_NO_PROFILER
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#endif
+
+#endif
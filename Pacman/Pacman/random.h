@@ -0,0 +1,70 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+// Полное состояние генератора (для снимков игры)
+struct RandomState {
+    uint64_t state;
+    uint64_t increment;
+};
+
+// Маленький быстрый генератор PCG32 (O'Neill, pcg-random.org).
+// Состояние - два 64-битных слова, никакого глобального состояния:
+// у каждой игры свой генератор, поэтому партии воспроизводимы и
+// могут идти в разных потоках.
+class Random {
+private:
+    uint64_t state;
+    uint64_t increment;
+
+public:
+    explicit Random(uint64_t seedValue = 1, uint64_t stream = 0) {
+        seed(seedValue, stream);
+    }
+
+    // Один и тот же seed (и stream) всегда даёт одну и ту же последовательность
+    void seed(uint64_t seedValue, uint64_t stream = 0) {
+        state = 0;
+        increment = (stream << 1) | 1u;
+        next();
+        state += seedValue;
+        next();
+    }
+
+    RandomState getState() const {
+        RandomState s;
+        s.state = state;
+        s.increment = increment;
+        return s;
+    }
+
+    void setState(const RandomState& s) {
+        state = s.state;
+        increment = s.increment;
+    }
+
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + increment;
+        uint32_t xorshifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+        uint32_t rot = static_cast<uint32_t>(old >> 59);
+        return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+    }
+
+    // Равномерно в [0, bound) без смещения (метод Лемира)
+    uint32_t nextBelow(uint32_t bound) {
+        uint64_t m = static_cast<uint64_t>(next()) * bound;
+        uint32_t low = static_cast<uint32_t>(m);
+        if (low < bound) {
+            uint32_t threshold = (0u - bound) % bound;
+            while (low < threshold) {
+                m = static_cast<uint64_t>(next()) * bound;
+                low = static_cast<uint32_t>(m);
+            }
+        }
+        return static_cast<uint32_t>(m >> 32);
+    }
+};
+
+#endif
@@ -0,0 +1,204 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Ключ сортировки, от старших битов к младшим:
+//   проход (8) | материал (16) | меш (16) | глубина (24)
+// После сортировки проходы идут друг за другом, внутри прохода каждый
+// материал ставится один раз, внутри материала каждый меш привязывается
+// один раз, а одинаковые меши рисуются от ближних к дальним.
+const int RENDER_KEY_DEPTH_BITS = 24;
+const int RENDER_KEY_MESH_BITS = 16;
+const int RENDER_KEY_MATERIAL_BITS = 16;
+const int RENDER_KEY_PASS_BITS = 8;
+const uint32_t RENDER_KEY_MAX_DEPTH = (1u << RENDER_KEY_DEPTH_BITS) - 1;
+
+inline uint64_t renderKey(uint32_t pass, uint32_t material, uint32_t mesh, uint32_t depth) {
+    return (static_cast<uint64_t>(pass) << (RENDER_KEY_MATERIAL_BITS + RENDER_KEY_MESH_BITS + RENDER_KEY_DEPTH_BITS)) |
+        (static_cast<uint64_t>(material) << (RENDER_KEY_MESH_BITS + RENDER_KEY_DEPTH_BITS)) |
+        (static_cast<uint64_t>(mesh) << RENDER_KEY_DEPTH_BITS) |
+        std::min(depth, RENDER_KEY_MAX_DEPTH);
+}
+
+inline uint32_t renderKeyPass(uint64_t key) {
+    return static_cast<uint32_t>(key >> (RENDER_KEY_MATERIAL_BITS + RENDER_KEY_MESH_BITS + RENDER_KEY_DEPTH_BITS));
+}
+
+inline uint32_t renderKeyMaterial(uint64_t key) {
+    return static_cast<uint32_t>(key >> (RENDER_KEY_MESH_BITS + RENDER_KEY_DEPTH_BITS)) & ((1u << RENDER_KEY_MATERIAL_BITS) - 1);
+}
+
+inline uint32_t renderKeyMesh(uint64_t key) {
+    return static_cast<uint32_t>(key >> RENDER_KEY_DEPTH_BITS) & ((1u << RENDER_KEY_MESH_BITS) - 1);
+}
+
+// Расстояние до камеры в поле глубины ключа: [0, range] -> [0, RENDER_KEY_MAX_DEPTH]
+inline uint32_t renderDepth(float distance, float range) {
+    if (!(distance > 0.0f)) return 0;
+    if (distance >= range) return RENDER_KEY_MAX_DEPTH;
+    return static_cast<uint32_t>(distance / range * RENDER_KEY_MAX_DEPTH);
+}
+
+// Элемент очереди: ключ и номер объекта в таблице вызывающего (матрица,
+// параметры), сама очередь в объекты не заглядывает
+struct RenderItem {
+    uint64_t key;
+    uint32_t object;
+};
+
+// Сортировка по ключу: LSD radix по байтам, устойчивая. Гистограммы всех
+// восьми байтов считаются за один проход; байт, одинаковый у всех ключей
+// (старшие биты прохода, пустая глубина), не переставляется. scratch -
+// рабочий буфер того же размера, его ёмкость переиспользуется. Короткую
+// очередь (кадр сцены - пара десятков элементов) быстрее отсортировать
+// вставками, чем обнулять и проходить гистограммы.
+const size_t RENDER_QUEUE_INSERTION_SORT_MAX = 48;
+
+inline void radixSortRenderItems(std::vector<RenderItem>& items, std::vector<RenderItem>& scratch) {
+    const size_t count = items.size();
+    if (count < 2) return;
+    if (count <= RENDER_QUEUE_INSERTION_SORT_MAX) {
+        for (size_t i = 1; i < count; i++) {
+            RenderItem item = items[i];
+            size_t j = i;
+            for (; j > 0 && items[j - 1].key > item.key; j--) items[j] = items[j - 1];
+            items[j] = item;
+        }
+        return;
+    }
+    scratch.resize(count);
+
+    uint32_t histograms[8][256] = {};
+    for (const RenderItem& item : items) {
+        for (int digit = 0; digit < 8; digit++) histograms[digit][(item.key >> (digit * 8)) & 0xff]++;
+    }
+
+    RenderItem* source = items.data();
+    RenderItem* target = scratch.data();
+    for (int digit = 0; digit < 8; digit++) {
+        uint32_t* histogram = histograms[digit];
+        if (histogram[(source[0].key >> (digit * 8)) & 0xff] == count) continue;
+
+        uint32_t offset = 0;
+        for (int bucket = 0; bucket < 256; bucket++) {
+            uint32_t size = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += size;
+        }
+        for (size_t i = 0; i < count; i++) {
+            const RenderItem& item = source[i];
+            target[histogram[(item.key >> (digit * 8)) & 0xff]++] = item;
+        }
+        std::swap(source, target);
+    }
+    if (source != items.data()) items.swap(scratch);
+}
+
+// Исполнитель очереди: переключает проходы, материалы и меши и рисует.
+// Очередь зовёт begin/bind, только когда значение из ключа сменилось.
+class RenderBackend {
+public:
+    virtual ~RenderBackend() {}
+    virtual void beginPass(uint32_t pass) = 0;
+    virtual void bindMaterial(uint32_t material) = 0;
+    virtual void bindMesh(uint32_t mesh) = 0;
+    virtual void unbindMesh(uint32_t mesh) = 0;
+    virtual void draw(uint32_t mesh, uint32_t object) = 0;
+};
+
+// Сколько раз за кадр очередь переключала состояние
+struct RenderQueueCounts {
+    uint64_t items;
+    uint64_t passes;
+    uint64_t materials;
+    uint64_t meshes;
+};
+
+// Отрисовка кадра как список элементов: кадр отправляет в очередь всё, что
+// видно, sort() упорядочивает по ключу, execute() проходит по порядку.
+// Память - только у векторов, после первых кадров она не выделяется.
+class RenderQueue {
+private:
+    std::vector<RenderItem> items;
+    std::vector<RenderItem> scratch;
+
+public:
+    void reserve(size_t capacity) {
+        items.reserve(capacity);
+        scratch.reserve(capacity);
+    }
+
+    void clear() { items.clear(); }
+
+    void submit(uint64_t key, uint32_t object) {
+        RenderItem item = { key, object };
+        items.push_back(item);
+    }
+
+    size_t size() const { return items.size(); }
+    const RenderItem& operator[](size_t index) const { return items[index]; }
+
+    void sort() { radixSortRenderItems(items, scratch); }
+
+    RenderQueueCounts execute(RenderBackend& backend) const {
+        RenderQueueCounts counts = {};
+        const uint32_t none = ~0u;
+        uint32_t pass = none, material = none, mesh = none;
+        for (const RenderItem& item : items) {
+            uint32_t itemPass = renderKeyPass(item.key);
+            uint32_t itemMaterial = renderKeyMaterial(item.key);
+            uint32_t itemMesh = renderKeyMesh(item.key);
+            if (itemPass != pass) {
+                if (mesh != none) backend.unbindMesh(mesh);
+                backend.beginPass(itemPass);
+                pass = itemPass;
+                material = mesh = none;
+                counts.passes++;
+            }
+            if (itemMaterial != material) {
+                backend.bindMaterial(itemMaterial);
+                material = itemMaterial;
+                counts.materials++;
+            }
+            if (itemMesh != mesh) {
+                if (mesh != none) backend.unbindMesh(mesh);
+                backend.bindMesh(itemMesh);
+                mesh = itemMesh;
+                counts.meshes++;
+            }
+            backend.draw(itemMesh, item.object);
+            counts.items++;
+        }
+        if (mesh != none) backend.unbindMesh(mesh);
+        return counts;
+    }
+};
+
+// Сводка по кадрам для --gl-stats
+struct RenderQueueStats {
+    uint64_t frames;
+    RenderQueueCounts total;
+
+    RenderQueueStats() : frames(0), total() {}
+
+    void add(const RenderQueueCounts& frame) {
+        frames++;
+        total.items += frame.items;
+        total.passes += frame.passes;
+        total.materials += frame.materials;
+        total.meshes += frame.meshes;
+    }
+
+    void print(FILE* out) const {
+        double n = frames > 0 ? static_cast<double>(frames) : 1.0;
+        std::fprintf(out, "Render queue: per frame %.1f draws, %.1f passes, %.1f material binds, %.1f mesh binds\n",
+            total.items / n, total.passes / n, total.materials / n, total.meshes / n);
+    }
+};
+
+#endif
@@ -0,0 +1,374 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "game.h"
+#include "action.h"
+#include "gameState.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Ввод одного тика одним байтом: Action в младших битах и флаги клавиш.
+// Флаги применяются в порядке restart, next level, start, затем действие.
+enum InputBits : uint8_t {
+    INPUT_ACTION_MASK = 0x07,
+    INPUT_START = 0x08,
+    INPUT_NEXT_LEVEL = 0x10,
+    INPUT_RESTART = 0x20
+};
+
+inline void applyInput(Game& game, uint8_t input) {
+    if (input & INPUT_RESTART) game.restart();
+    if ((input & INPUT_NEXT_LEVEL) && game.isLevelComplete()) game.nextLevel();
+    if (input & INPUT_START) game.startGame();
+    applyAction(game, static_cast<Action>(input & INPUT_ACTION_MASK));
+}
+
+// Заменяет действие во вводе, оставляя флаги
+inline uint8_t withAction(uint8_t input, Action action) {
+    return static_cast<uint8_t>((input & ~INPUT_ACTION_MASK) | action);
+}
+
+// Одинаковый ввод подряд length тиков
+struct InputRun {
+    uint8_t input;
+    uint32_t length;
+};
+
+// Снимок перед тиком tick и место ввода этого тика в списке серий.
+// Призраки сверх MAX_GHOSTS - в extraGhosts.
+struct ReplayKeyframe {
+    uint32_t tick;
+    uint32_t run;
+    uint32_t offset;
+    GameState state;
+    std::vector<GhostState> extraGhosts;
+};
+
+// Запись партии: снимок на старте записи и ввод по тикам сериями.
+// Каждые keyframeInterval тиков хранится снимок, поэтому перемотка
+// к любому тику стоит не больше keyframeInterval тиков симуляции.
+// В файле - только начальный снимок и серии (varint); остальные снимки
+// восстанавливаются при загрузке пересчётом партии.
+class Replay {
+private:
+    uint64_t seed;
+    int width, height;
+    int keyframeInterval;
+    uint32_t tickCount;
+    std::vector<InputRun> runs;
+    std::vector<ReplayKeyframe> keyframes;
+
+    static void writeVarint(std::vector<uint8_t>& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    static bool readVarint(const std::vector<uint8_t>& in, size_t& pos, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos >= in.size()) return false;
+            uint8_t byte = in[pos++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    // Пересчитывает снимки после первого, проигрывая ввод
+    bool rebuildKeyframes() {
+        keyframes.resize(1);
+        Game game(width, height, seed);
+        if (!game.restore(keyframes[0].state, keyframes[0].extraGhosts)) return false;
+
+        uint32_t tick = 0;
+        const uint32_t interval = static_cast<uint32_t>(keyframeInterval);
+        for (uint32_t r = 0; r < runs.size(); r++) {
+            uint32_t i = 0;
+            while (i < runs[r].length) {
+                if (tick > 0 && tick % interval == 0) {
+                    addKeyframe(game, tick, r, i);
+                }
+                if (runs[r].input == 0) {
+                    // Без ввода - прыжком до конца серии или до снимка
+                    uint32_t count = std::min(runs[r].length - i, interval - tick % interval);
+                    game.fastForward(count);
+                    tick += count;
+                    i += count;
+                }
+                else {
+                    applyInput(game, runs[r].input);
+                    game.update();
+                    tick++;
+                    i++;
+                }
+            }
+        }
+        return true;
+    }
+
+    void addKeyframe(const Game& game, uint32_t tick, uint32_t run, uint32_t offset) {
+        ReplayKeyframe keyframe = ReplayKeyframe();
+        keyframe.tick = tick;
+        keyframe.run = run;
+        keyframe.offset = offset;
+        game.snapshot(keyframe.state, keyframe.extraGhosts);
+        keyframes.push_back(keyframe);
+    }
+
+    friend class ReplayRecorder;
+
+public:
+    Replay() : seed(0), width(0), height(0), keyframeInterval(600), tickCount(0) {}
+
+    uint64_t getSeed() const { return seed; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getKeyframeInterval() const { return keyframeInterval; }
+    uint32_t getTickCount() const { return tickCount; }
+    const std::vector<InputRun>& getRuns() const { return runs; }
+    const std::vector<ReplayKeyframe>& getKeyframes() const { return keyframes; }
+
+    // Последний снимок не позже tick
+    const ReplayKeyframe& keyframeBefore(uint32_t tick) const {
+        size_t k = tick / keyframeInterval;
+        if (k >= keyframes.size()) k = keyframes.size() - 1;
+        return keyframes[k];
+    }
+
+    // Файл: "PMRP", версия, varint-поля заголовка, серии (байт ввода +
+    // varint длины), затем начальный снимок как есть и призраки сверх
+    // MAX_GHOSTS (varint числа и GhostState подряд). Снимок зависит от
+    // раскладки GameState, поэтому файл читается той же сборкой игры.
+    std::vector<uint8_t> encode() const {
+        std::vector<uint8_t> out = { 'P', 'M', 'R', 'P', 2 };
+        writeVarint(out, seed);
+        writeVarint(out, static_cast<uint64_t>(width));
+        writeVarint(out, static_cast<uint64_t>(height));
+        writeVarint(out, static_cast<uint64_t>(keyframeInterval));
+        writeVarint(out, tickCount);
+        writeVarint(out, runs.size());
+        for (const InputRun& run : runs) {
+            out.push_back(run.input);
+            writeVarint(out, run.length);
+        }
+        writeVarint(out, sizeof(GameState));
+        if (!keyframes.empty()) {
+            const uint8_t* state = reinterpret_cast<const uint8_t*>(&keyframes[0].state);
+            out.insert(out.end(), state, state + sizeof(GameState));
+            const std::vector<GhostState>& extra = keyframes[0].extraGhosts;
+            writeVarint(out, extra.size());
+            const uint8_t* ghosts = reinterpret_cast<const uint8_t*>(extra.data());
+            out.insert(out.end(), ghosts, ghosts + extra.size() * sizeof(GhostState));
+        }
+        return out;
+    }
+
+    bool decode(const std::vector<uint8_t>& in) {
+        if (in.size() < 5 || in[0] != 'P' || in[1] != 'M' || in[2] != 'R' || in[3] != 'P' || in[4] != 2) {
+            return false;
+        }
+
+        size_t pos = 5;
+        uint64_t values[6];
+        for (uint64_t& value : values) {
+            if (!readVarint(in, pos, value)) return false;
+        }
+        // Каждая серия занимает в файле хотя бы два байта
+        if (values[1] == 0 || values[2] == 0 || values[3] == 0 || values[5] > in.size() / 2) return false;
+
+        std::vector<InputRun> newRuns(static_cast<size_t>(values[5]));
+        uint64_t total = 0;
+        for (InputRun& run : newRuns) {
+            uint64_t length;
+            if (pos >= in.size()) return false;
+            run.input = in[pos++];
+            if (!readVarint(in, pos, length)) return false;
+            run.length = static_cast<uint32_t>(length);
+            total += length;
+        }
+        if (total != values[4]) return false;
+
+        uint64_t stateSize, extraCount;
+        if (!readVarint(in, pos, stateSize) || stateSize != sizeof(GameState) ||
+            in.size() - pos < sizeof(GameState)) {
+            return false;
+        }
+        size_t statePos = pos;
+        pos += sizeof(GameState);
+        if (!readVarint(in, pos, extraCount) || extraCount > (in.size() - pos) / sizeof(GhostState) ||
+            in.size() - pos != extraCount * sizeof(GhostState)) {
+            return false;
+        }
+
+        seed = values[0];
+        width = static_cast<int>(values[1]);
+        height = static_cast<int>(values[2]);
+        keyframeInterval = static_cast<int>(values[3]);
+        tickCount = static_cast<uint32_t>(values[4]);
+        runs.swap(newRuns);
+        keyframes.resize(1);
+        keyframes[0] = ReplayKeyframe();
+        std::memcpy(&keyframes[0].state, &in[statePos], sizeof(GameState));
+        keyframes[0].extraGhosts.resize(static_cast<size_t>(extraCount));
+        if (extraCount > 0) {
+            std::memcpy(keyframes[0].extraGhosts.data(), &in[pos], static_cast<size_t>(extraCount) * sizeof(GhostState));
+        }
+        return rebuildKeyframes();
+    }
+
+    bool save(const char* path) const {
+        std::vector<uint8_t> data = encode();
+        FILE* file = std::fopen(path, "wb");
+        if (!file) return false;
+        bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+        return std::fclose(file) == 0 && ok;
+    }
+
+    bool load(const char* path) {
+        FILE* file = std::fopen(path, "rb");
+        if (!file) return false;
+        std::vector<uint8_t> data;
+        uint8_t buffer[4096];
+        size_t read;
+        while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            data.insert(data.end(), buffer, buffer + read);
+        }
+        std::fclose(file);
+        return decode(data);
+    }
+};
+
+// Пишет партию: каждый тик идёт через step(), который запоминает ввод,
+// применяет его и двигает игру
+class ReplayRecorder {
+private:
+    Replay replay;
+
+public:
+    // Запись начинается с текущего состояния game
+    void start(const Game& game, uint64_t seed, int keyframeInterval = 600) {
+        replay = Replay();
+        replay.seed = seed;
+        replay.width = game.getMap().getWidth();
+        replay.height = game.getMap().getHeight();
+        replay.keyframeInterval = keyframeInterval > 0 ? keyframeInterval : 1;
+        replay.addKeyframe(game, 0, 0, 0);
+    }
+
+    // Память под запись на ticks тиков вперёд, чтобы step() не выделял её
+    // посреди игры. Серий - четверть тиков: нажатие даёт две серии (тик
+    // нажатия и отрезок после него), то есть хватит на нажатие раз в 8 тиков.
+    void reserve(uint32_t ticks) {
+        replay.runs.reserve(ticks / 4);
+        replay.keyframes.reserve(ticks / replay.keyframeInterval + 1);
+    }
+
+    void step(Game& game, uint8_t input) {
+        std::vector<InputRun>& runs = replay.runs;
+        if (!runs.empty() && runs.back().input == input) {
+            runs.back().length++;
+        }
+        else {
+            InputRun run;
+            run.input = input;
+            run.length = 1;
+            runs.push_back(run);
+        }
+
+        uint32_t tick = replay.tickCount++;
+        if (tick > 0 && tick % replay.keyframeInterval == 0) {
+            replay.addKeyframe(game, tick, static_cast<uint32_t>(runs.size() - 1), runs.back().length - 1);
+        }
+
+        applyInput(game, input);
+        game.update();
+    }
+
+    const Replay& getReplay() const { return replay; }
+};
+
+// Проигрывает запись на переданной игре (карта того же размера)
+class ReplayPlayer {
+private:
+    const Replay& replay;
+    Game& game;
+    uint32_t tick;
+    uint32_t run;
+    uint32_t offset;
+
+public:
+    ReplayPlayer(const Replay& replay, Game& game)
+        : replay(replay), game(game), tick(0), run(0), offset(0) {
+        seek(0);
+    }
+
+    bool atEnd() const { return tick >= replay.getTickCount(); }
+    uint32_t getTick() const { return tick; }
+
+    // Один тик записи; false, если запись кончилась
+    bool step() {
+        if (atEnd()) return false;
+        const InputRun& current = replay.getRuns()[run];
+        applyInput(game, current.input);
+        game.update();
+        tick++;
+        if (++offset >= current.length) {
+            run++;
+            offset = 0;
+        }
+        return true;
+    }
+
+    // Встаёт перед тиком target: ближайший снимок и не больше
+    // keyframeInterval тиков симуляции
+    bool seek(uint32_t target) {
+        if (replay.getKeyframes().empty()) return false;
+        if (target > replay.getTickCount()) target = replay.getTickCount();
+
+        const ReplayKeyframe& keyframe = replay.keyframeBefore(target);
+        if (!game.restore(keyframe.state, keyframe.extraGhosts)) return false;
+        tick = keyframe.tick;
+        run = keyframe.run;
+        offset = keyframe.offset;
+        advance(target - tick);
+        return true;
+    }
+
+    // До ticks тиков записи; серии без ввода идут через Game::fastForward.
+    // Возвращает, сколько тиков прошло.
+    uint32_t advance(uint32_t ticks) {
+        uint32_t done = 0;
+        while (done < ticks && !atEnd()) {
+            const InputRun& current = replay.getRuns()[run];
+            if (current.input != 0) {
+                step();
+                done++;
+                continue;
+            }
+            uint32_t count = std::min(ticks - done, current.length - offset);
+            game.fastForward(count);
+            tick += count;
+            done += count;
+            offset += count;
+            if (offset >= current.length) {
+                run++;
+                offset = 0;
+            }
+        }
+        return done;
+    }
+
+    // Проигрывает до конца и возвращает число тиков
+    uint32_t runToEnd() {
+        advance(replay.getTickCount() - tick);
+        return tick;
+    }
+};
+
+#endif
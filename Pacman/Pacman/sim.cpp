@@ -0,0 +1,324 @@
+// Headless-симуляция: гоняет Game::update() без GLUT/Assimp и меряет скорость
+#include "simulation.h"
+#include "replay.h"
+#include "profiler.h"
+#include "allocationHooks.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static void printUsage(const char* program) {
+    std::printf("Usage: %s [options]\n", program);
+    std::printf("  --games N    number of games to play (default 1000)\n");
+    std::printf("  --seed S     seed of the first game, game i uses S + i (default 1)\n");
+    std::printf("  --ticks T    tick limit per game (default 20000)\n");
+    std::printf("  --threads N  worker threads, 0 = all cores (default 1)\n");
+    std::printf("  --ghosts N   ghosts per level in batch games (default 4)\n");
+    std::printf("  --verbose    print game events (power mode, deaths...) on stdout\n");
+    std::printf("  --record F   play one bot game with --seed and save its replay to F\n");
+    std::printf("  --replay F   re-simulate the replay in F at full speed\n");
+    std::printf("  --seek T     with --replay: stop before tick T and print the state\n");
+    std::printf("  --hashes N   with --replay: print the state hash every N ticks\n");
+    std::printf("  --profile F  time Game::update zones, print a summary and write a Chrome trace to F\n");
+    std::printf("  --check-allocations  play --games bot games on one thread and fail if a tick,\n");
+    std::printf("               restart or level change allocates after the first (warm-up) game\n");
+}
+
+// Одна партия бота через ReplayRecorder; пройденный уровень - флаги
+// next level и start на следующем тике, как пробел и клавиша в окне
+static int recordGame(const char* path, uint32_t seed, int maxTicks, bool verbose) {
+    Game game(SIM_MAP_WIDTH, SIM_MAP_HEIGHT, seed);
+    RandomBot bot(seed);
+    ReplayRecorder recorder;
+    recorder.start(game, seed);
+    ConsoleEventLog log;
+
+    uint8_t flags = INPUT_START;
+    for (int tick = 0; tick < maxTicks && !game.isGameOver(); tick++) {
+        recorder.step(game, withAction(flags, bot.act(game)));
+        if (verbose) game.getEvents().drain(log);
+        flags = game.isLevelComplete() ? (INPUT_NEXT_LEVEL | INPUT_START) : 0;
+    }
+
+    const Replay& replay = recorder.getReplay();
+    if (!replay.save(path)) {
+        std::fprintf(stderr, "cannot write %s\n", path);
+        return 1;
+    }
+    std::printf("recorded:    %s\n", path);
+    std::printf("ticks:       %u\n", replay.getTickCount());
+    std::printf("score:       %d (level %d)\n", game.getScore(), game.getLevel());
+    std::printf("input runs:  %zu\n", replay.getRuns().size());
+    std::printf("file size:   %zu bytes\n", replay.encode().size());
+    return 0;
+}
+
+// Печатает "тик хеш" строками: потоки двух сборок сравниваются diff-ом
+class HashPrinter : public StateHashListener {
+public:
+    void onStateHash(uint32_t tick, uint64_t hash) override {
+        std::printf("%u %016llx\n", tick, static_cast<unsigned long long>(hash));
+    }
+};
+
+static int playReplay(const char* path, long long seekTick, int hashInterval, bool verbose) {
+    Replay replay;
+    if (!replay.load(path)) {
+        std::fprintf(stderr, "cannot read replay %s\n", path);
+        return 1;
+    }
+
+    Game game(replay.getWidth(), replay.getHeight(), replay.getSeed());
+    ReplayPlayer player(replay, game);
+    HashPrinter printer;
+    if (hashInterval > 0) {
+        game.setStateHashListener(&printer, static_cast<uint32_t>(hashInterval));
+    }
+    auto start = std::chrono::steady_clock::now();
+    if (verbose) {
+        // С начала записи и небольшими шагами, чтобы кольцо событий не
+        // переполнилось между выводами
+        uint32_t target = seekTick >= 0 ? static_cast<uint32_t>(seekTick) : replay.getTickCount();
+        ConsoleEventLog log;
+        player.seek(0);
+        while (player.getTick() < target && player.advance(std::min<uint32_t>(32, target - player.getTick())) > 0) {
+            game.getEvents().drain(log);
+        }
+    }
+    else if (seekTick >= 0) {
+        player.seek(static_cast<uint32_t>(seekTick));
+    }
+    else {
+        player.runToEnd();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const Pacman& pacman = game.getPacman();
+    std::printf("tick:        %u of %u\n", player.getTick(), replay.getTickCount());
+    std::printf("score:       %d (level %d)\n", game.getScore(), game.getLevel());
+    std::printf("pacman:      %.3f %.3f\n", pacman.getX(), pacman.getY());
+    for (const Ghost& ghost : game.getGhosts()) {
+        std::printf("ghost %d:     %.3f %.3f%s\n", static_cast<int>(ghost.getColor()),
+            ghost.getX(), ghost.getY(), ghost.isVulnerable() ? " (vulnerable)" : "");
+    }
+    std::printf("game over:   %s\n", game.isGameOver() ? "yes" : "no");
+    std::printf("state hash:  %016llx\n", static_cast<unsigned long long>(game.stateHash()));
+    std::printf("time:        %.6f s\n", seconds);
+    return 0;
+}
+
+// Доводит партию до конца уровня: снимок без монет и энергетиков и один
+// тик. false, если уровень так и не засчитан. Выделений не делает, но
+// выполняется вне окна счётчика - проверяется только сама смена уровня.
+static bool completeLevel(Game& game) {
+    GameState state;
+    if (!game.snapshot(state)) return false;
+    std::memset(state.map.coins, 0, sizeof(state.map.coins));
+    std::memset(state.map.powerPoints, 0, sizeof(state.map.powerPoints));
+    state.map.coinCount = 0;
+    state.map.powerPointCount = 0;
+    state.map.coinHash = 0;
+    state.map.powerPointHash = 0;
+    state.gameOver = 0;
+    state.gameStarted = 1;
+    if (!game.restore(state)) return false;
+    game.update();
+    return game.isLevelComplete();
+}
+
+// Проверка нулевых выделений: партии ботов на одном потоке, выделения
+// считаются по тикам и по сменам уровня/рестартам. Первая партия - прогрев
+// (буферы потоков, первый рост векторов) и в проверку не входит.
+static int checkAllocations(int games, uint32_t seed, int maxTicks) {
+    if (games < 2) {
+        std::printf("--check-allocations needs --games 2 or more: the first game is warm-up\n");
+        return 1;
+    }
+    AllocationTracker::setEnabled(true);
+    AllocationStats ticks, transitions;
+
+    for (int g = 0; g < games; g++) {
+        if (g == 1) {
+            ticks = AllocationStats();
+            transitions = AllocationStats();
+            AllocationTracker::resetSites();
+        }
+
+        Game game(SIM_MAP_WIDTH, SIM_MAP_HEIGHT, seed + g);
+        RandomBot bot(seed + g);
+        game.startGame();
+        for (int t = 0; t < maxTicks && !game.isGameOver(); t++) {
+            AllocationWindow window;
+            applyAction(game, bot.act(game));
+            game.update();
+            ticks.add(window.elapsed());
+        }
+
+        // Бот до конца уровня не доходит: убираем с карты все пеллеты через
+        // снимок, и следующий тик засчитывает уровень - смена уровня дальше
+        // настоящая, а не пустой вызов nextLevel()
+        if (!completeLevel(game)) {
+            std::printf("game %d: level did not complete after clearing the pellets\n", g);
+            AllocationTracker::setEnabled(false);
+            return 1;
+        }
+        {
+            AllocationWindow window;
+            game.nextLevel();
+            game.startGame();
+            transitions.add(window.elapsed());
+        }
+        {
+            AllocationWindow window;
+            game.restart();
+            game.startGame();
+            transitions.add(window.elapsed());
+        }
+    }
+    AllocationTracker::setEnabled(false);
+
+    std::printf("games:       %d (first one is warm-up)\n", games);
+    ticks.print(stdout, "tick");
+    transitions.print(stdout, "level");
+    if (ticks.windows == 0 || transitions.windows == 0) {
+        std::printf("steady state: nothing measured after warm-up\n");
+        return 1;
+    }
+    if (ticks.allocations == 0 && transitions.allocations == 0) {
+        std::printf("steady state: no allocations\n");
+        return 0;
+    }
+    std::printf("steady state ALLOCATES:\n");
+    AllocationTracker::printSites(stdout);
+    return 1;
+}
+
+// Партии ботов на runner и сводка по ним
+static int runBatch(int games, uint32_t seed, int maxTicks, int threads, bool verbose, int ghostCount) {
+    long long totalTicks = 0;
+    long long totalScore = 0;
+    int gamesOver = 0;
+    int maxLevel = 0;
+
+    ParallelRunner runner(threads);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<GameResult> results = runGames(runner, seed, games, maxTicks, verbose, ghostCount);
+    auto end = std::chrono::steady_clock::now();
+
+    for (const GameResult& result : results) {
+        totalTicks += result.ticks;
+        totalScore += result.score;
+        gamesOver += result.gameOver ? 1 : 0;
+        if (result.level > maxLevel) maxLevel = result.level;
+    }
+    double seconds = std::chrono::duration<double>(end - start).count();
+    if (seconds <= 0.0) seconds = 1e-9;
+
+    std::printf("games:       %d (%d game over, %d hit tick limit)\n", games, gamesOver, games - gamesOver);
+    std::printf("threads:     %d\n", runner.getThreadCount());
+    std::printf("ghosts:      %d per level\n", ghostCount);
+    std::printf("ticks:       %lld\n", totalTicks);
+    std::printf("avg score:   %.1f\n", static_cast<double>(totalScore) / games);
+    std::printf("max level:   %d\n", maxLevel);
+    std::printf("time:        %.3f s\n", seconds);
+    std::printf("games/s:     %.1f\n", games / seconds);
+    std::printf("ticks/s:     %.0f\n", totalTicks / seconds);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int games = 1000;
+    uint32_t seed = 1;
+    int maxTicks = 20000;
+    int threads = 1;
+    int ghostCount = CLASSIC_GHOST_COUNT;
+    bool verbose = false;
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    long long seekTick = -1;
+    int hashInterval = 0;
+    const char* profilePath = nullptr;
+    bool allocationCheck = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--games") == 0 && hasValue) {
+            games = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(arg, "--seed") == 0 && hasValue) {
+            seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(arg, "--ticks") == 0 && hasValue) {
+            maxTicks = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(arg, "--threads") == 0 && hasValue) {
+            threads = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(arg, "--ghosts") == 0 && hasValue) {
+            ghostCount = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(arg, "--verbose") == 0) {
+            verbose = true;
+        }
+        else if (std::strcmp(arg, "--record") == 0 && hasValue) {
+            recordPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--replay") == 0 && hasValue) {
+            replayPath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--seek") == 0 && hasValue) {
+            seekTick = std::atoll(argv[++i]);
+        }
+        else if (std::strcmp(arg, "--hashes") == 0 && hasValue) {
+            hashInterval = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(arg, "--profile") == 0 && hasValue) {
+            profilePath = argv[++i];
+        }
+        else if (std::strcmp(arg, "--check-allocations") == 0) {
+            allocationCheck = true;
+        }
+        else {
+            printUsage(argv[0]);
+            return std::strcmp(arg, "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    if (games <= 0 || maxTicks <= 0 || ghostCount < 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (profilePath) {
+        Profiler::setEnabled(true);
+    }
+
+    int status;
+    if (recordPath) {
+        status = recordGame(recordPath, seed, maxTicks, verbose);
+    }
+    else if (replayPath) {
+        status = playReplay(replayPath, seekTick, hashInterval, verbose);
+    }
+    else if (allocationCheck) {
+        status = checkAllocations(games, seed, maxTicks);
+    }
+    else {
+        status = runBatch(games, seed, maxTicks, threads, verbose, ghostCount);
+    }
+
+    if (profilePath) {
+        Profiler::setEnabled(false);
+        Profiler::printSummary(stdout);
+        if (!Profiler::writeChromeTrace(profilePath)) {
+            std::fprintf(stderr, "cannot write %s\n", profilePath);
+            return 1;
+        }
+        std::printf("trace:       %s\n", profilePath);
+    }
+    return status;
+}
@@ -0,0 +1,91 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "game.h"
+#include "action.h"
+#include "random.h"
+#include "parallelRunner.h"
+#include <cstdint>
+#include <vector>
+
+// Размер классической карты (совпадает с M x N в main.cpp)
+const int SIM_MAP_WIDTH = 19;
+const int SIM_MAP_HEIGHT = 21;
+
+// Результат одной headless-партии
+struct GameResult {
+    uint32_t seed;
+    int score;
+    int level;
+    int ticks;
+    bool gameOver;
+    uint64_t stateHash; // хеш состояния в конце партии
+};
+
+// Простейший "игрок": держит направление и иногда случайно его меняет
+class RandomBot {
+private:
+    Random rng;
+
+public:
+    // Отдельный поток PCG, чтобы бот не повторял последовательность призраков
+    explicit RandomBot(uint64_t seed) : rng(seed, 1) {}
+
+    Action act(const Game& game) {
+        const Pacman& pacman = game.getPacman();
+        bool stopped = pacman.getDirectionX() == 0 && pacman.getDirectionY() == 0;
+
+        // Упёрлись в стену - обязательно меняем направление, иначе изредка
+        if (stopped || rng.nextBelow(8) == 0) {
+            return static_cast<Action>(ACTION_UP + rng.nextBelow(4));
+        }
+        return ACTION_NONE;
+    }
+};
+
+// Играет одну партию до проигрыша или до лимита тиков; log (если есть)
+// получает события игры после каждого тика
+inline GameResult runGame(uint32_t seed, int maxTicks, GameEventListener* log = nullptr,
+    int ghostCount = CLASSIC_GHOST_COUNT) {
+    Game game(SIM_MAP_WIDTH, SIM_MAP_HEIGHT, seed, ghostCount);
+    RandomBot bot(seed);
+
+    game.startGame();
+    int ticks = 0;
+    while (ticks < maxTicks && !game.isGameOver()) {
+        applyAction(game, bot.act(game));
+        game.update();
+        ticks++;
+        if (log) game.getEvents().drain(*log);
+
+        if (game.isLevelComplete()) {
+            game.nextLevel();
+            game.startGame();
+        }
+    }
+
+    GameResult result;
+    result.seed = seed;
+    result.score = game.getScore();
+    result.level = game.getLevel();
+    result.ticks = ticks;
+    result.gameOver = game.isGameOver();
+    result.stateHash = game.stateHash();
+    return result;
+}
+
+// Играет count партий с сидами firstSeed + i на всех потоках runner;
+// результат i лежит в слоте i независимо от числа потоков. verbose -
+// события в консоль, каждая строка с сидом своей партии.
+inline std::vector<GameResult> runGames(ParallelRunner& runner, uint32_t firstSeed, size_t count, int maxTicks,
+    bool verbose = false, int ghostCount = CLASSIC_GHOST_COUNT) {
+    std::vector<GameResult> results(count);
+    runner.run(count, [&results, firstSeed, maxTicks, verbose, ghostCount](size_t i) {
+        uint32_t seed = firstSeed + static_cast<uint32_t>(i);
+        ConsoleEventLog log(seed);
+        results[i] = runGame(seed, maxTicks, verbose ? &log : nullptr, ghostCount);
+    });
+    return results;
+}
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef STATEHASH_H
+#define STATEHASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Финальное перемешивание splitmix64: хорошие ключи Зобриста из индекса
+constexpr uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Ключ поля для линейных хешей акторов: сумма ключ * значение по полям
+// меняется на ключ * разность при каждой записи поля, как Зобрист у монет.
+// Нечётный, чтобы младшие биты разности не терялись; от константы
+// считается при компиляции.
+constexpr uint64_t stateFieldKey(uint64_t field) {
+    return mix64(field * 0x2545F4914F6CDD1DULL) | 1;
+}
+
+// Номера ключей stateFieldKey: до STATE_KEYS_PACMAN - слова Game, дальше
+// поля Пакмана, с STATE_KEYS_GHOSTS - поля призраков (призраков между
+// собой различает GhostTable::getHashSum). Ключи не пересекаются, поэтому
+// суммы Пакмана и призраков складываются в stateHash() как есть.
+const uint64_t STATE_KEYS_PACMAN = 8;
+const uint64_t STATE_KEYS_GHOSTS = 32;
+
+// Два 32-битных поля одним словом: ключ * слово - одно умножение на пару.
+// Нечётный ключ переставляет слова, так что пары не склеиваются.
+constexpr uint64_t stateHashPair(int32_t low, int32_t high) {
+    return static_cast<uint32_t>(low) | static_cast<uint64_t>(static_cast<uint32_t>(high)) << 32;
+}
+
+// Получатель хешей состояния из Game::update()
+class StateHashListener {
+public:
+    virtual ~StateHashListener() {}
+    // tick - число выполненных update(), hash - состояние после него
+    virtual void onStateHash(uint32_t tick, uint64_t hash) = 0;
+};
+
+// Собирает поток хешей в вектор
+class StateHashRecorder : public StateHashListener {
+private:
+    std::vector<uint32_t> ticks;
+    std::vector<uint64_t> hashes;
+
+public:
+    void onStateHash(uint32_t tick, uint64_t hash) override {
+        ticks.push_back(tick);
+        hashes.push_back(hash);
+    }
+
+    void clear() {
+        ticks.clear();
+        hashes.clear();
+    }
+
+    const std::vector<uint32_t>& getTicks() const { return ticks; }
+    const std::vector<uint64_t>& getHashes() const { return hashes; }
+};
+
+// Первая позиция, где потоки хешей расходятся, или -1. Потоки разной
+// длины расходятся там, где кончается короткий.
+inline long long firstDivergence(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b) {
+    size_t n = a.size() < b.size() ? a.size() : b.size();
+    for (size_t i = 0; i < n; i++) {
+        if (a[i] != b[i]) return static_cast<long long>(i);
+    }
+    return a.size() == b.size() ? -1 : static_cast<long long>(n);
+}
+
+// Первый тик в [first, last], где hashA(t) != hashB(t), или -1.
+// Разошедшиеся детерминированные симуляции дальше не сходятся, поэтому
+// хватает O(log) сравнений; hashA/hashB обычно перематывают запись
+// (ReplayPlayer::seek) и хешируют состояние.
+template <typename HashA, typename HashB>
+long long bisectDivergence(uint32_t first, uint32_t last, HashA hashA, HashB hashB) {
+    if (hashA(last) == hashB(last)) return -1;
+    if (hashA(first) != hashB(first)) return first;
+
+    // Инвариант: на first совпадают, на last - уже нет
+    while (last - first > 1) {
+        uint32_t middle = first + (last - first) / 2;
+        if (hashA(middle) == hashB(middle)) first = middle;
+        else last = middle;
+    }
+    return last;
+}
+
+#endif
@@ -0,0 +1,208 @@
+#ifndef WALLMESH_H
+#define WALLMESH_H
+
+#include "gameMap.h"
+#include "meshData.h"
+#include <cstdint>
+#include <vector>
+
+// Размеры стен в мировых координатах. Клетка (j, i) стоит в
+// x = j * cellSize, z = (height - i) * cellSize - так же, как пеллеты
+// (PelletLayout) и фигуры в buildRenderQueue.
+struct WallShape {
+    float cellSize;
+    float wallSize; // сторона стены в клетке: от коридора стена отступает на (cellSize - wallSize) / 2
+    float bottom;
+    float top;
+};
+
+// Что было бы при отрисовке стен кубами и что получилось в меше
+struct WallMeshStats {
+    int wallCells;
+    int quads;
+};
+
+// Строит стены всего лабиринта одним статическим мешем. Стена - клетка
+// WALL с отступом от соседних проходов; между соседними стенами отступа
+// нет, поэтому грани, прижатые друг к другу, в меш не попадают, как и дно
+// (оно лежит выше пола и сверху не видно). Совпадающие по плоскости грани
+// сливаются жадно: верх - в прямоугольники, бока - в полосы.
+//
+// Сетка ведётся мельче клеток: каждая клетка делится на 3 x 3 части -
+// отступ, середина, отступ. Середина занята, если клетка - стена; часть у
+// ребра - если стена и соседняя клетка за ребром; угловая - если стены все
+// четыре клетки у этого угла. Вне карты стен нет.
+class WallMeshBuilder {
+private:
+    std::vector<uint8_t> solid; // мелкая сетка fineWidth x fineHeight
+    std::vector<uint8_t> used;  // уже покрытые прямоугольниками верха
+    int fineWidth, fineHeight;
+    WallShape shape;
+    int mapHeight;
+
+    bool isSolid(int c, int r) const {
+        if (c < 0 || r < 0 || c >= fineWidth || r >= fineHeight) return false;
+        return solid[static_cast<size_t>(r) * fineWidth + c] != 0;
+    }
+
+    // Граница мелкой сетки по x: 0 - край клетки, 1 и 2 - края середины
+    float boundaryX(int b) const {
+        float inset = (shape.cellSize - shape.wallSize) * 0.5f;
+        const float offsets[3] = { 0.0f, inset, inset + shape.wallSize };
+        return (b / 3) * shape.cellSize - shape.cellSize * 0.5f + offsets[b % 3];
+    }
+
+    // По z строки карты идут в обратную сторону
+    float boundaryZ(int b) const {
+        float inset = (shape.cellSize - shape.wallSize) * 0.5f;
+        const float offsets[3] = { 0.0f, inset, inset + shape.wallSize };
+        return (mapHeight - b / 3) * shape.cellSize + shape.cellSize * 0.5f - offsets[b % 3];
+    }
+
+    void fillSolid(const GameMap& map) {
+        const GridView grid = map.getGrid();
+        const int width = map.getWidth();
+        auto isWall = [&grid, width, this](int j, int i) {
+            return j >= 0 && i >= 0 && j < width && i < mapHeight && grid.at(j, i) == WALL;
+        };
+
+        for (int r = 0; r < fineHeight; r++) {
+            for (int c = 0; c < fineWidth; c++) {
+                int j = c / 3, i = r / 3;
+                int dx = c % 3 - 1, dy = r % 3 - 1;
+                bool filled = isWall(j, i) &&
+                    (dx == 0 || isWall(j + dx, i)) &&
+                    (dy == 0 || isWall(j, i + dy)) &&
+                    (dx == 0 || dy == 0 || isWall(j + dx, i + dy));
+                solid[static_cast<size_t>(r) * fineWidth + c] = filled ? 1 : 0;
+            }
+        }
+    }
+
+    // Верх: жадные прямоугольники - вправо, пока можно, затем вниз целыми строками
+    int addTops(MeshData& out) {
+        int quads = 0;
+        used.assign(solid.size(), 0);
+        for (int r = 0; r < fineHeight; r++) {
+            for (int c = 0; c < fineWidth; c++) {
+                size_t start = static_cast<size_t>(r) * fineWidth + c;
+                if (!solid[start] || used[start]) continue;
+
+                int w = 1;
+                while (c + w < fineWidth && solid[start + w] && !used[start + w]) w++;
+                int h = 1;
+                for (; r + h < fineHeight; h++) {
+                    size_t row = static_cast<size_t>(r + h) * fineWidth + c;
+                    int k = 0;
+                    while (k < w && solid[row + k] && !used[row + k]) k++;
+                    if (k < w) break;
+                }
+                for (int y = r; y < r + h; y++) {
+                    for (int x = c; x < c + w; x++) used[static_cast<size_t>(y) * fineWidth + x] = 1;
+                }
+
+                float x0 = boundaryX(c), x1 = boundaryX(c + w);
+                float zNear = boundaryZ(r + h), zFar = boundaryZ(r);
+                const float corners[4][3] = {
+                    { x0, shape.top, zNear }, { x0, shape.top, zFar },
+                    { x1, shape.top, zFar }, { x1, shape.top, zNear } };
+                out.addQuad(corners, 0.0f, 1.0f, 0.0f);
+                quads++;
+            }
+        }
+        return quads;
+    }
+
+    // Бока вдоль x (нормаль +-x): полосы подряд идущих частей одного столбца
+    int addSidesX(MeshData& out) {
+        int quads = 0;
+        for (int c = 0; c < fineWidth; c++) {
+            for (int side = -1; side <= 1; side += 2) {
+                int r = 0;
+                while (r < fineHeight) {
+                    if (!isSolid(c, r) || isSolid(c + side, r)) { r++; continue; }
+                    int end = r + 1;
+                    while (end < fineHeight && isSolid(c, end) && !isSolid(c + side, end)) end++;
+
+                    float x = boundaryX(side > 0 ? c + 1 : c);
+                    float zMin = boundaryZ(end), zMax = boundaryZ(r);
+                    if (side > 0) {
+                        const float corners[4][3] = {
+                            { x, shape.bottom, zMin }, { x, shape.top, zMin },
+                            { x, shape.top, zMax }, { x, shape.bottom, zMax } };
+                        out.addQuad(corners, 1.0f, 0.0f, 0.0f);
+                    }
+                    else {
+                        const float corners[4][3] = {
+                            { x, shape.bottom, zMin }, { x, shape.bottom, zMax },
+                            { x, shape.top, zMax }, { x, shape.top, zMin } };
+                        out.addQuad(corners, -1.0f, 0.0f, 0.0f);
+                    }
+                    quads++;
+                    r = end;
+                }
+            }
+        }
+        return quads;
+    }
+
+    // Бока вдоль z: строка r - 1 лежит дальше по +z, r + 1 - ближе к -z
+    int addSidesZ(MeshData& out) {
+        int quads = 0;
+        for (int r = 0; r < fineHeight; r++) {
+            for (int side = -1; side <= 1; side += 2) {
+                int c = 0;
+                while (c < fineWidth) {
+                    if (!isSolid(c, r) || isSolid(c, r + side)) { c++; continue; }
+                    int end = c + 1;
+                    while (end < fineWidth && isSolid(end, r) && !isSolid(end, r + side)) end++;
+
+                    float xMin = boundaryX(c), xMax = boundaryX(end);
+                    if (side < 0) {
+                        float z = boundaryZ(r);
+                        const float corners[4][3] = {
+                            { xMin, shape.bottom, z }, { xMax, shape.bottom, z },
+                            { xMax, shape.top, z }, { xMin, shape.top, z } };
+                        out.addQuad(corners, 0.0f, 0.0f, 1.0f);
+                    }
+                    else {
+                        float z = boundaryZ(r + 1);
+                        const float corners[4][3] = {
+                            { xMin, shape.bottom, z }, { xMin, shape.top, z },
+                            { xMax, shape.top, z }, { xMax, shape.bottom, z } };
+                        out.addQuad(corners, 0.0f, 0.0f, -1.0f);
+                    }
+                    quads++;
+                    c = end;
+                }
+            }
+        }
+        return quads;
+    }
+
+public:
+    WallMeshBuilder() : fineWidth(0), fineHeight(0), shape(), mapHeight(0) {}
+
+    // out очищается; рабочие массивы и out сохраняют ёмкость между сборками
+    WallMeshStats build(const GameMap& map, const WallShape& wallShape, MeshData& out) {
+        shape = wallShape;
+        mapHeight = map.getHeight();
+        fineWidth = map.getWidth() * 3;
+        fineHeight = mapHeight * 3;
+        solid.resize(static_cast<size_t>(fineWidth) * fineHeight);
+        fillSolid(map);
+
+        out.clear();
+        WallMeshStats stats = { 0, 0 };
+        const GridView grid = map.getGrid();
+        for (int i = 0; i < mapHeight; i++) {
+            for (int j = 0; j < map.getWidth(); j++) {
+                if (grid.at(j, i) == WALL) stats.wallCells++;
+            }
+        }
+        stats.quads = addTops(out) + addSidesX(out) + addSidesZ(out);
+        return stats;
+    }
+};
+
+#endif
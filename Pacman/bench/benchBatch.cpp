@@ -0,0 +1,40 @@
+// Масштабирование GameBatch::step по размеру пачки
+#include "gameBatch.h"
+#include "simulation.h"
+#include "benchUtil.h"
+#include <cstdio>
+#include <vector>
+
+int main() {
+    const size_t sizes[] = { 1, 16, 256, 1024, 4096 };
+    const long long totalGameTicks = 4000000;
+
+    std::printf("%8s %12s %14s %14s\n", "games", "steps", "steps/s", "game ticks/s");
+    for (size_t n : sizes) {
+        GameBatch batch(n, SIM_MAP_WIDTH, SIM_MAP_HEIGHT, 1);
+        std::vector<Action> actions(n, ACTION_NONE);
+        std::vector<float> rewards(n);
+        std::vector<uint8_t> dones(n);
+        std::vector<int> scores(n);
+        batch.setOutputs(rewards.data(), dones.data(), scores.data());
+
+        long long steps = totalGameTicks / static_cast<long long>(n);
+        uint32_t rng = 12345;
+        long long finished = 0;
+
+        Stopwatch timer;
+        for (long long s = 0; s < steps; s++) {
+            for (size_t i = 0; i < n; i++) {
+                uint32_t r = benchRandom(rng);
+                actions[i] = (r & 7) == 0 ? static_cast<Action>(ACTION_UP + (r >> 3) % 4) : ACTION_NONE;
+            }
+            batch.step(actions.data(), n);
+            finished += dones[0];
+        }
+        double seconds = timer.seconds();
+        doNotOptimize(finished);
+
+        std::printf("%8zu %12lld %14.0f %14.0f\n", n, steps, steps / seconds, steps * n / seconds);
+    }
+    return 0;
+}
@@ -0,0 +1,160 @@
+// Проверка касаний Пакмана с призраками: прежний цикл по вектору объектов
+// призраков против массивов позиций GhostPositions (SIMD), плюс проверка,
+// что оба находят одного и того же первого призрака
+#include "simulation.h"
+#include "benchUtil.h"
+#include <cstdio>
+#include <vector>
+
+// Призрак целиком в одном объекте, как был устроен Ghost до GhostTable:
+// при обходе в кэш идёт всё состояние, а не только x, y
+struct LegacyGhost {
+    int x, y;
+    int speed;
+    int dx, dy;
+    int respawnX, respawnY;
+    int frightenedTimer;
+    int modeTimer;
+    int scatterChaseCycle;
+    GhostColor color;
+    bool vulnerable;
+    bool inScatterMode;
+    bool modeJustChanged;
+};
+
+// Прежний checkCollisions без последствий касания: первый по порядку
+static int legacyFirstContact(const std::vector<LegacyGhost>& ghosts, int px, int py) {
+    const int64_t collisionRadius = COLLISION_RADIUS;
+    for (size_t i = 0; i < ghosts.size(); i++) {
+        if (fixedDistanceSquared(px, py, ghosts[i].x, ghosts[i].y) <
+            collisionRadius * collisionRadius) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+// Призраки в квадрате spread вокруг (px, py)
+static void placeGhosts(std::vector<LegacyGhost>& ghosts, GhostPositions& positions, int px, int py,
+    int spread, uint32_t& rng) {
+    positions.resize(ghosts.size());
+    for (size_t i = 0; i < ghosts.size(); i++) {
+        ghosts[i].x = px + static_cast<int>(benchRandom(rng) % (2 * spread + 1)) - spread;
+        ghosts[i].y = py + static_cast<int>(benchRandom(rng) % (2 * spread + 1)) - spread;
+        positions.set(i, ghosts[i].x, ghosts[i].y);
+    }
+}
+
+static int checkEquivalence() {
+    static const int counts[] = { 1, 3, 4, 5, 7, 8, 9, 17, 64, 1000 };
+    static const int spreads[] = { 700, 2000, 20000 };
+    uint32_t rng = 12345;
+    long long checks = 0, mismatches = 0;
+
+    for (int count : counts) {
+        std::vector<LegacyGhost> ghosts(count, LegacyGhost());
+        GhostPositions positions;
+        for (int spread : spreads) {
+            for (int round = 0; round < 2000; round++) {
+                int px = static_cast<int>(benchRandom(rng) % 20000);
+                int py = static_cast<int>(benchRandom(rng) % 22000);
+                placeGhosts(ghosts, positions, px, py, spread, rng);
+                checks++;
+                if (legacyFirstContact(ghosts, px, py) != positions.firstContact(px, py, COLLISION_RADIUS)) {
+                    mismatches++;
+                }
+            }
+        }
+    }
+
+    // Точно на границе: 700 по оси и (420, 560) - не касание, 699 - касание
+    static const int edges[][2] = { {700, 0}, {0, -700}, {420, 560}, {-560, 420}, {699, 0}, {419, 559} };
+    for (const auto& edge : edges) {
+        for (int count : counts) {
+            std::vector<LegacyGhost> ghosts(count, LegacyGhost());
+            GhostPositions positions;
+            positions.resize(count);
+            // Все далеко, кроме последнего - он на проверяемой границе
+            for (int i = 0; i < count; i++) {
+                ghosts[i].x = ghosts[i].y = 50000;
+                positions.set(i, 50000, 50000);
+            }
+            int last = count - 1;
+            ghosts[last].x = 10000 + edge[0];
+            ghosts[last].y = 10000 + edge[1];
+            positions.set(last, ghosts[last].x, ghosts[last].y);
+            checks++;
+            if (legacyFirstContact(ghosts, 10000, 10000) != positions.firstContact(10000, 10000, COLLISION_RADIUS)) {
+                mismatches++;
+            }
+        }
+    }
+
+    std::printf("equivalence: %lld checks, %lld mismatches\n", checks, mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
+
+static void benchScan() {
+    static const int counts[] = { 4, 64, 1024, 4096 };
+    std::printf("\n%-8s %14s %14s %10s\n", "ghosts", "AoS ns/scan", "SoA ns/scan", "speedup");
+    uint32_t rng = 777;
+    for (int count : counts) {
+        std::vector<LegacyGhost> ghosts(count, LegacyGhost());
+        GhostPositions positions;
+        // Пакман в стороне: касаний нет, оба проходят всех призраков
+        placeGhosts(ghosts, positions, 10000, 10000, 8000, rng);
+        const int px = 40000, py = 40000;
+        const long long scans = 50000000LL / count + 1;
+
+        int sum = 0;
+        Stopwatch timer;
+        for (long long s = 0; s < scans; s++) sum += legacyFirstContact(ghosts, px, py + static_cast<int>(s & 1));
+        double legacy = timer.seconds() * 1e9 / scans;
+
+        timer.restart();
+        for (long long s = 0; s < scans; s++) sum += positions.firstContact(px, py + static_cast<int>(s & 1), COLLISION_RADIUS);
+        double soa = timer.seconds() * 1e9 / scans;
+        doNotOptimize(sum);
+
+        std::printf("%-8d %14.1f %14.1f %9.1fx\n", count, legacy, soa, legacy / soa);
+    }
+}
+
+// Game::update() целиком с заданным числом призраков; бот, рестарт после
+// проигрыша, чтобы тики оставались "живыми"
+static void benchGame() {
+    static const int counts[] = { 4, 64, 1024 };
+    std::printf("\n%-8s %14s\n", "ghosts", "ns/tick");
+    for (int count : counts) {
+        Game game(SIM_MAP_WIDTH, SIM_MAP_HEIGHT, 3, count);
+        RandomBot bot(3);
+        game.startGame();
+        long long ticks = 0;
+        Stopwatch timer;
+        while (timer.seconds() < 0.5) {
+            for (int t = 0; t < 1000; t++, ticks++) {
+                if (game.isGameOver()) {
+                    game.restart();
+                    game.startGame();
+                }
+                applyAction(game, bot.act(game));
+                game.update();
+            }
+        }
+        std::printf("%-8d %14.1f\n", count, timer.seconds() * 1e9 / ticks);
+    }
+}
+
+int main() {
+#if defined(GHOST_POSITIONS_AVX)
+    std::printf("GhostPositions: AVX, 8 ghosts per step\n");
+#elif defined(GHOST_POSITIONS_SSE2)
+    std::printf("GhostPositions: SSE2, 4 ghosts per step\n");
+#else
+    std::printf("GhostPositions: scalar\n");
+#endif
+    int status = checkEquivalence();
+    benchScan();
+    benchGame();
+    return status;
+}
@@ -0,0 +1,56 @@
+// Память и время построения таблицы расстояний для классической и больших карт
+#include "gameMap.h"
+#include "benchUtil.h"
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+// Проверка: шаг nextHop ведёт в клетку, которая ближе к цели ровно на 1
+static long long countBrokenHops(const GameMap& map, const DistanceTable& table, int samples) {
+    long long broken = 0;
+    uint32_t rng = 17;
+    int width = map.getWidth();
+    int height = map.getHeight();
+    for (int s = 0; s < samples; s++) {
+        int fx = benchRandom(rng) % width, fy = benchRandom(rng) % height;
+        int tx = benchRandom(rng) % width, ty = benchRandom(rng) % height;
+        int d = table.distance(fx, fy, tx, ty);
+        if (d <= 0) continue;
+        int hop = table.nextHop(fx, fy, tx, ty);
+        if (hop < 0 || table.distance(fx + MAZE_DIRECTIONS[hop][0], fy + MAZE_DIRECTIONS[hop][1], tx, ty) != d - 1) {
+            broken++;
+        }
+    }
+    return broken;
+}
+
+int main(int argc, char** argv) {
+    int scales[] = { 1, 2, 3 };
+    int maxScale = argc > 1 ? std::atoi(argv[1]) : 3;
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (threads <= 0) threads = 1;
+
+    std::printf("%-8s %7s %12s %12s %12s %8s\n", "map", "tiles", "table MB", "1 thread ms", "all thr. ms", "broken");
+    for (int scale : scales) {
+        if (scale > maxScale) break;
+        // Больше классической - та же расстановка стен на увеличенном поле
+        GameMap map(19 * scale, 21 * scale);
+
+        Stopwatch timer;
+        map.buildDistanceTable(1);
+        double singleMs = timer.seconds() * 1000.0;
+
+        timer.restart();
+        map.buildDistanceTable(threads);
+        double parallelMs = timer.seconds() * 1000.0;
+
+        const DistanceTable& table = *map.getDistanceTable();
+        char name[32];
+        std::snprintf(name, sizeof(name), "%dx%d", map.getWidth(), map.getHeight());
+        std::printf("%-8s %7d %12.2f %12.1f %12.1f %8lld\n", name, table.getTileCount(),
+            table.memoryUsage() / (1024.0 * 1024.0), singleMs, parallelMs,
+            countBrokenHops(map, table, 100000));
+    }
+    std::printf("threads: %d\n", threads);
+    return 0;
+}
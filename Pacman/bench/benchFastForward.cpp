@@ -0,0 +1,137 @@
+// Перемотка по событиям: Game::fastForward() против update() по тику.
+// Состояние после каждого отрезка, поток хешей и события игры должны
+// совпадать; скорость меряется только на тиках идущей партии.
+#include "simulation.h"
+#include "replay.h"
+#include "benchUtil.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+class EventCollector : public GameEventListener {
+public:
+    std::vector<GameEvent> events;
+    void onGameEvent(const GameEvent& event) override { events.push_back(event); }
+};
+
+static bool sameEvents(const std::vector<GameEvent>& a, const std::vector<GameEvent>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].tick != b[i].tick || a[i].type != b[i].type || a[i].ghost != b[i].ghost ||
+            a[i].x != b[i].x || a[i].y != b[i].y || a[i].value != b[i].value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void takeSnapshot(const Game& game, GameState& state) {
+    std::memset(&state, 0, sizeof(state));
+    game.snapshot(state);
+}
+
+// Ввод, который нужен, чтобы партия шла; иначе с шансом 1/inputEvery
+// случайное направление, как у человека, который жмёт клавиши изредка
+static uint8_t sparseInput(const Game& game, uint32_t& state, uint32_t inputEvery) {
+    if (game.isGameOver()) return INPUT_RESTART | INPUT_START;
+    if (game.isLevelComplete()) return INPUT_NEXT_LEVEL | INPUT_START;
+    if (!game.isGameStarted()) return INPUT_START;
+    if (benchRandom(state) % inputEvery != 0) return 0;
+    return withAction(0, static_cast<Action>(1 + benchRandom(state) % 4));
+}
+
+// Две одинаковые игры: одна по тику, другая прыжками случайной длины
+static bool sameAsPerTick(uint32_t seed, uint32_t hashInterval) {
+    Game perTick(SIM_MAP_WIDTH, SIM_MAP_HEIGHT, seed), jumping(SIM_MAP_WIDTH, SIM_MAP_HEIGHT, seed);
+    StateHashRecorder hashesA, hashesB;
+    EventCollector eventsA, eventsB;
+    if (hashInterval > 0) {
+        perTick.setStateHashListener(&hashesA, hashInterval);
+        jumping.setStateHashListener(&hashesB, hashInterval);
+    }
+
+    uint32_t state = seed * 2654435761u + 1;
+    for (int segment = 0; segment < 300; segment++) {
+        uint8_t input = sparseInput(perTick, state, 1);
+        applyInput(perTick, input);
+        perTick.update();
+        applyInput(jumping, input);
+        jumping.update();
+
+        uint32_t length = 1 + benchRandom(state) % (segment % 5 == 0 ? 600 : 60);
+        for (uint32_t t = 0; t < length; t++) perTick.update();
+        jumping.fastForward(length);
+
+        GameState a, b;
+        takeSnapshot(perTick, a);
+        takeSnapshot(jumping, b);
+        if (std::memcmp(&a, &b, sizeof(GameState)) != 0) return false;
+        perTick.getEvents().drain(eventsA);
+        jumping.getEvents().drain(eventsB);
+    }
+    return hashesA.getHashes() == hashesB.getHashes() && hashesA.getTicks() == hashesB.getTicks() &&
+        sameEvents(eventsA.events, eventsB.events) && perTick.getEvents().getDropped() == 0;
+}
+
+static Replay recordSparseGame(uint32_t seed, int ticks, uint32_t inputEvery) {
+    Game game(SIM_MAP_WIDTH, SIM_MAP_HEIGHT, seed);
+    ReplayRecorder recorder;
+    recorder.start(game, seed);
+    uint32_t state = seed;
+    for (int t = 0; t < ticks; t++) {
+        recorder.step(game, sparseInput(game, state, inputEvery));
+    }
+    return recorder.getReplay();
+}
+
+// Серии без ввода в идущей партии: по тику и через fastForward
+static void measure(const std::vector<Replay>& replays, uint32_t inputEvery) {
+    double perTickSeconds = 0.0, jumpSeconds = 0.0;
+    long long liveTicks = 0;
+    bool same = true;
+    for (const Replay& replay : replays) {
+        Game perTick(SIM_MAP_WIDTH, SIM_MAP_HEIGHT), jumping(SIM_MAP_WIDTH, SIM_MAP_HEIGHT);
+        perTick.restore(replay.getKeyframes()[0].state);
+        jumping.restore(replay.getKeyframes()[0].state);
+        for (const InputRun& run : replay.getRuns()) {
+            if (run.input == 0 && perTick.isGameStarted() && !perTick.isGameOver()) {
+                Stopwatch timer;
+                for (uint32_t t = 0; t < run.length; t++) perTick.update();
+                perTickSeconds += timer.seconds();
+                timer.restart();
+                jumping.fastForward(run.length);
+                jumpSeconds += timer.seconds();
+                liveTicks += run.length;
+                continue;
+            }
+            for (uint32_t t = 0; t < run.length; t++) {
+                applyInput(perTick, run.input);
+                perTick.update();
+                applyInput(jumping, run.input);
+                jumping.update();
+            }
+        }
+        same = same && perTick.stateHash() == jumping.stateHash();
+    }
+    std::printf("%-16u %12.1f %12.1f %9.2fx %s\n", inputEvery, perTickSeconds * 1e9 / liveTicks,
+        jumpSeconds * 1e9 / liveTicks, perTickSeconds / jumpSeconds, same ? "same" : "DIFFERENT");
+}
+
+int main() {
+    const int games = 200;
+    int identical = 0;
+    for (uint32_t seed = 1; seed <= games; seed++) {
+        if (sameAsPerTick(seed, seed % 3 == 0 ? seed % 13 + 1 : 0)) identical++;
+    }
+    std::printf("fastForward vs update(): %d/%d games identical\n", identical, games);
+
+    std::printf("%-16s %12s %12s %10s\n", "input every", "update ns", "jump ns", "speedup");
+    const uint32_t inputEvery[] = { 15, 60, 600 };
+    for (uint32_t every : inputEvery) {
+        std::vector<Replay> replays;
+        for (uint32_t seed = 1; seed <= 50; seed++) replays.push_back(recordSparseGame(seed, 20000, every));
+        measure(replays, every);
+    }
+
+    return identical == games ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+// Ядро выбора направления призрака: прежняя версия на std::vector против новой
+#include "ghost.h"
+#include "simulation.h"
+#include "benchUtil.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// Считаем выделения памяти, чтобы показать их число на одно решение
+static long long allocationCount = 0;
+
+void* operator new(std::size_t size) {
+    allocationCount++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// Прежний chooseBestDirection после выравнивания по клетке, дословно
+static void legacySteerToTarget(const GameMap& map, int currentX, int currentY, int targetX, int targetY,
+    bool restricted, int& dx, int& dy) {
+    std::vector<std::pair<int, int>> directions = { {0, -1}, {-1, 0}, {0, 1}, {1, 0} };
+    std::vector<std::pair<int, int>> validDirections;
+    std::vector<float> distances;
+
+    for (const auto& dir : directions) {
+        int newDx = dir.first;
+        int newDy = dir.second;
+        if (newDx == -dx && newDy == -dy) continue;
+        if (restricted && newDy == -1) continue;
+
+        int testX = currentX + newDx;
+        int testY = currentY + newDy;
+        if (map.canMove(testX, testY)) {
+            float distance = std::sqrt(std::pow(targetX - testX, 2) + std::pow(targetY - testY, 2));
+            validDirections.push_back({ newDx, newDy });
+            distances.push_back(distance);
+        }
+    }
+
+    if (!validDirections.empty()) {
+        float minDistance = *std::min_element(distances.begin(), distances.end());
+        for (size_t i = 0; i < validDirections.size(); ++i) {
+            if (distances[i] == minDistance) {
+                dx = validDirections[i].first;
+                dy = validDirections[i].second;
+                break;
+            }
+        }
+    }
+    else if (map.canMove(currentX - dx, currentY - dy)) {
+        dx = -dx;
+        dy = -dy;
+    }
+}
+
+struct Decision {
+    int x, y, targetX, targetY, dx, dy;
+    bool restricted;
+};
+
+int main() {
+    GameMap map(SIM_MAP_WIDTH, SIM_MAP_HEIGHT);
+    GridView grid = map.getGrid();
+
+    // Случайные решения в проходимых клетках с целями в том же диапазоне,
+    // что у scatter-углов и упреждения Pinky/Inky
+    std::vector<Decision> decisions;
+    uint32_t rng = 99;
+    static const int headings[5][2] = { {0, 0}, {0, -1}, {-1, 0}, {0, 1}, {1, 0} };
+    while (decisions.size() < 100000) {
+        Decision d;
+        d.x = static_cast<int>(benchRandom(rng) % SIM_MAP_WIDTH);
+        d.y = static_cast<int>(benchRandom(rng) % SIM_MAP_HEIGHT);
+        if (grid.at(d.x, d.y) == WALL) continue;
+        d.targetX = static_cast<int>(benchRandom(rng) % 40) - 5;
+        d.targetY = static_cast<int>(benchRandom(rng) % 40) - 5;
+        const int* heading = headings[benchRandom(rng) % 5];
+        d.dx = heading[0];
+        d.dy = heading[1];
+        d.restricted = benchRandom(rng) % 8 == 0;
+        decisions.push_back(d);
+    }
+
+    // Совпадение выбора
+    long long mismatches = 0;
+    for (const Decision& d : decisions) {
+        int ldx = d.dx, ldy = d.dy, ndx = d.dx, ndy = d.dy;
+        legacySteerToTarget(map, d.x, d.y, d.targetX, d.targetY, d.restricted, ldx, ldy);
+        GhostTable::steerToTarget(map, d.x, d.y, d.targetX, d.targetY, d.restricted, ndx, ndy);
+        if (ldx != ndx || ldy != ndy) mismatches++;
+    }
+
+    const int rounds = 50;
+    long long checksum = 0;
+
+    long long allocationsBefore = allocationCount;
+    Stopwatch timer;
+    for (int r = 0; r < rounds; r++) {
+        for (const Decision& d : decisions) {
+            int dx = d.dx, dy = d.dy;
+            legacySteerToTarget(map, d.x, d.y, d.targetX, d.targetY, d.restricted, dx, dy);
+            checksum += dx * 3 + dy;
+        }
+    }
+    double legacySeconds = timer.seconds();
+    long long legacyAllocations = allocationCount - allocationsBefore;
+
+    allocationsBefore = allocationCount;
+    timer.restart();
+    for (int r = 0; r < rounds; r++) {
+        for (const Decision& d : decisions) {
+            int dx = d.dx, dy = d.dy;
+            GhostTable::steerToTarget(map, d.x, d.y, d.targetX, d.targetY, d.restricted, dx, dy);
+            checksum += dx * 3 + dy;
+        }
+    }
+    double newSeconds = timer.seconds();
+    long long newAllocations = allocationCount - allocationsBefore;
+    doNotOptimize(checksum);
+
+    double total = static_cast<double>(decisions.size()) * rounds;
+    std::printf("%-10s %16s %18s\n", "kernel", "decisions/s", "allocs/decision");
+    std::printf("%-10s %16.0f %18.2f\n", "vector", total / legacySeconds, legacyAllocations / total);
+    std::printf("%-10s %16.0f %18.2f\n", "fixed", total / newSeconds, newAllocations / total);
+    std::printf("speedup: %.2fx, mismatched choices: %lld of %zu\n",
+        legacySeconds / newSeconds, mismatches, decisions.size());
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+// Плоская сетка GameMap против прежней vector<vector<Cell>>: память и скорость запросов
+#include "gameMap.h"
+#include "simulation.h"
+#include "benchUtil.h"
+#include <cstdio>
+#include <vector>
+
+// Прежнее представление карты (12 байт на клетку, отдельный блок на строку)
+struct LegacyCell {
+    int x, y;
+    CellType type;
+    bool isWalkable() const { return type == EMPTY || type == COIN || type == POWER_POINT; }
+};
+
+class LegacyMap {
+private:
+    std::vector<std::vector<LegacyCell>> grid;
+    int width, height;
+
+public:
+    explicit LegacyMap(const GameMap& map) : width(map.getWidth()), height(map.getHeight()) {
+        GridView view = map.getGrid();
+        grid.resize(height, std::vector<LegacyCell>(width));
+        for (int i = 0; i < height; i++) {
+            for (int j = 0; j < width; j++) {
+                grid[i][j] = { j, i, view.at(j, i) };
+            }
+        }
+    }
+
+    bool canMove(float fx, float fy) const {
+        int x = static_cast<int>(fx);
+        int y = static_cast<int>(fy);
+        if (x < 0 || x >= width || y < 0 || y >= height) return false;
+        return grid[y][x].isWalkable();
+    }
+    bool hasCoin(int x, int y) const {
+        if (x < 0 || x >= width || y < 0 || y >= height) return false;
+        return grid[y][x].type == COIN;
+    }
+    bool hasPowerPoint(int x, int y) const {
+        if (x < 0 || x >= width || y < 0 || y >= height) return false;
+        return grid[y][x].type == POWER_POINT;
+    }
+
+    // Полезные данные плюс заголовки векторов и служебные 16 байт на блок кучи
+    size_t memoryUsage() const {
+        const size_t heapOverhead = 16;
+        size_t bytes = sizeof(LegacyMap) + grid.capacity() * sizeof(std::vector<LegacyCell>) + heapOverhead;
+        for (const auto& row : grid) {
+            bytes += row.capacity() * sizeof(LegacyCell) + heapOverhead;
+        }
+        return bytes;
+    }
+};
+
+template <typename Map>
+static double runQueries(const Map& map, const std::vector<int>& xs, const std::vector<int>& ys, int rounds) {
+    long long hits = 0;
+    Stopwatch timer;
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < xs.size(); i++) {
+            hits += map.canMove(static_cast<float>(xs[i]), static_cast<float>(ys[i]));
+            hits += map.hasCoin(xs[i], ys[i]);
+            hits += map.hasPowerPoint(xs[i], ys[i]);
+        }
+    }
+    double seconds = timer.seconds();
+    doNotOptimize(hits);
+    return xs.size() * 3.0 * rounds / seconds;
+}
+
+int main() {
+    GameMap map(SIM_MAP_WIDTH, SIM_MAP_HEIGHT);
+    LegacyMap legacy(map);
+
+    // Случайные клетки карты и её рамки - как соседи, которых проверяют актёры
+    std::vector<int> xs(4096), ys(4096);
+    uint32_t rng = 7;
+    for (size_t i = 0; i < xs.size(); i++) {
+        xs[i] = static_cast<int>(benchRandom(rng) % (SIM_MAP_WIDTH + 2)) - 1;
+        ys[i] = static_cast<int>(benchRandom(rng) % (SIM_MAP_HEIGHT + 2)) - 1;
+    }
+    const int rounds = 2000;
+
+    double legacyRate = runQueries(legacy, xs, ys, rounds);
+    double flatRate = runQueries(map, xs, ys, rounds);
+
+    std::printf("%-22s %12s %16s\n", "map", "bytes", "queries/s");
+    std::printf("%-22s %12zu %16.0f\n", "vector<vector<Cell>>", legacy.memoryUsage(), legacyRate);
+    std::printf("%-22s %12zu %16.0f\n", "flat padded grid", map.memoryUsage(), flatRate);
+    std::printf("memory: %.1fx smaller per map, queries: %.2fx faster\n",
+        static_cast<double>(legacy.memoryUsage()) / map.memoryUsage(), flatRate / legacyRate);
+
+    // Сетка стен одна на все карты этого размера (копии игр, параллельные
+    // прогоны), поэтому считается отдельно от карты
+    size_t shared = map.getLayout().memoryUsage();
+    std::printf("shared wall grid: %zu bytes once per map size; single map with it: %.1fx smaller\n",
+        shared, static_cast<double>(legacy.memoryUsage()) / (map.memoryUsage() + shared));
+
+    const MazeGraph& graph = map.getGraph();
+    std::printf("maze graph: %zu junctions, %zu corridors\n", graph.getNodes().size(), graph.getEdges().size());
+    return 0;
+}
@@ -0,0 +1,123 @@
+// Хеш состояния: цена включения в Game::update(), проверка инкрементального
+// хеша монет и поиск первого расходящегося тика двух записей
+#include "simulation.h"
+#include "replay.h"
+#include "benchUtil.h"
+#include <algorithm>
+#include <cstdio>
+
+class ChecksumListener : public StateHashListener {
+public:
+    uint64_t sum = 0;
+    void onStateHash(uint32_t, uint64_t hash) override { sum ^= hash; }
+};
+
+// Партии ботов подряд; listener == nullptr - хеш выключен
+static double ticksPerSecond(int games, StateHashListener* listener, uint32_t interval, long long& ticks) {
+    ticks = 0;
+    Stopwatch timer;
+    for (int g = 0; g < games; g++) {
+        Game game(SIM_MAP_WIDTH, SIM_MAP_HEIGHT, g + 1);
+        game.setStateHashListener(listener, interval);
+        RandomBot bot(g + 1);
+        game.startGame();
+        for (int t = 0; t < 20000 && !game.isGameOver(); t++, ticks++) {
+            applyAction(game, bot.act(game));
+            game.update();
+        }
+    }
+    return ticks / timer.seconds();
+}
+
+// Хеш монет с нуля: свежая карта, из которой убраны те же клетки
+static bool pelletHashMatches(const GameMap& map) {
+    GameMap fresh(map.getWidth(), map.getHeight());
+    for (int y = 0; y < map.getHeight(); y++) {
+        for (int x = 0; x < map.getWidth(); x++) {
+            if (!map.hasCoin(x, y) && !map.hasPowerPoint(x, y)) fresh.collectAt(x, y);
+        }
+    }
+    return fresh.pelletHash() == map.pelletHash();
+}
+
+static Replay recordBotGame(uint32_t seed, int ticks, int changedTick) {
+    Game game(SIM_MAP_WIDTH, SIM_MAP_HEIGHT, seed);
+    RandomBot bot(seed);
+    ReplayRecorder recorder;
+    recorder.start(game, seed, 120);
+    uint8_t flags = INPUT_START;
+    for (int t = 0; t < ticks; t++) {
+        Action action = bot.act(game);
+        if (t == changedTick) action = action == ACTION_LEFT ? ACTION_RIGHT : ACTION_LEFT;
+        recorder.step(game, withAction(flags, action));
+        // Проигрыш - сразу новая партия, чтобы запись шла все ticks тиков
+        if (game.isGameOver()) flags = INPUT_RESTART | INPUT_START;
+        else flags = game.isLevelComplete() ? (INPUT_NEXT_LEVEL | INPUT_START) : 0;
+    }
+    return recorder.getReplay();
+}
+
+int main() {
+    // Инкрементальный хеш монет против пересчёта с нуля
+    int checked = 0, wrong = 0;
+    for (uint32_t seed = 1; seed <= 20; seed++) {
+        Game game(SIM_MAP_WIDTH, SIM_MAP_HEIGHT, seed);
+        RandomBot bot(seed);
+        game.startGame();
+        for (int t = 0; t < 3000 && !game.isGameOver(); t++) {
+            applyAction(game, bot.act(game));
+            game.update();
+            if (t % 50 == 0) {
+                checked++;
+                if (!pelletHashMatches(game.getMap())) wrong++;
+            }
+        }
+    }
+    std::printf("pellet hash vs rebuild:  %d/%d match\n", checked - wrong, checked);
+
+    // Цена хеша: без него, на каждом тике, каждые 60 тиков. Режимы идут
+    // кругами, каждый круг в другом порядке, от каждого режима - лучший
+    // прогон: шум машины (частота, соседи) и место в круге не ложатся на
+    // один режим целиком.
+    const int games = 300, rounds = 9;
+    ChecksumListener listener;
+    StateHashListener* const listeners[3] = { nullptr, &listener, &listener };
+    const uint32_t intervals[3] = { 1, 1, 60 };
+    double best[3] = { 0, 0, 0 };
+    long long ticks;
+    ticksPerSecond(games, nullptr, 1, ticks); // прогрев
+    for (int r = 0; r < rounds; r++) {
+        for (int k = 0; k < 3; k++) {
+            int mode = (r + k) % 3;
+            best[mode] = std::max(best[mode], ticksPerSecond(games, listeners[mode], intervals[mode], ticks));
+        }
+    }
+    double off = best[0], every = best[1], every60 = best[2];
+    std::printf("%-18s %14s %10s\n", "hash", "ticks/s", "overhead");
+    std::printf("%-18s %14.0f %9.1f%%\n", "off", off, 0.0);
+    std::printf("%-18s %14.0f %9.1f%%\n", "every tick", every, (off / every - 1.0) * 100.0);
+    std::printf("%-18s %14.0f %9.1f%%\n", "every 60 ticks", every60, (off / every60 - 1.0) * 100.0);
+
+    Game probe(SIM_MAP_WIDTH, SIM_MAP_HEIGHT, 1);
+    const int hashes = 5000000;
+    Stopwatch timer;
+    for (int i = 0; i < hashes; i++) doNotOptimize(probe.stateHash());
+    double hashNs = timer.seconds() * 1e9 / hashes;
+    std::printf("stateHash():       %.1f ns (%.1f%% of a tick)\n", hashNs, hashNs * off / 1e9 * 100.0);
+
+    // Две записи отличаются вводом одного тика: бинарный поиск по перемотке
+    const int changedTick = 1234;
+    Replay original = recordBotGame(9, 4000, -1);
+    Replay changed = recordBotGame(9, 4000, changedTick);
+    Game gameA(SIM_MAP_WIDTH, SIM_MAP_HEIGHT, 9), gameB(SIM_MAP_WIDTH, SIM_MAP_HEIGHT, 9);
+    ReplayPlayer playerA(original, gameA), playerB(changed, gameB);
+    int seeks = 0;
+    auto hashA = [&](uint32_t t) { seeks++; playerA.seek(t); return gameA.stateHash(); };
+    auto hashB = [&](uint32_t t) { seeks++; playerB.seek(t); return gameB.stateHash(); };
+    long long found = bisectDivergence(0, original.getTickCount(), hashA, hashB);
+    std::printf("divergence: input changed before tick %d, first differing state after tick %lld (%d seeks)\n",
+        changedTick + 1, found, seeks);
+
+    bool ok = wrong == 0 && found == changedTick + 1;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,53 @@
+// Цена зон профайлера: выключенная зона, Game::update() без профайлера и
+// с ним, плюс выгрузка трассы и сводки
+#include "simulation.h"
+#include "profiler.h"
+#include "benchUtil.h"
+#include <cstdio>
+
+static double ticksPerSecond(int games) {
+    long long ticks = 0;
+    Stopwatch timer;
+    for (int g = 0; g < games; g++) {
+        Game game(SIM_MAP_WIDTH, SIM_MAP_HEIGHT, g + 1);
+        RandomBot bot(g + 1);
+        game.startGame();
+        for (int t = 0; t < 20000 && !game.isGameOver(); t++, ticks++) {
+            applyAction(game, bot.act(game));
+            game.update();
+        }
+    }
+    return ticks / timer.seconds();
+}
+
+int main(int argc, char** argv) {
+    const char* tracePath = argc > 1 ? argv[1] : "bench_profiler_trace.json";
+
+    const int zones = 50000000;
+    Stopwatch timer;
+    for (int i = 0; i < zones; i++) {
+        PROFILE_ZONE("disabled");
+        doNotOptimize(i);
+    }
+    std::printf("disabled zone:       %.2f ns\n", timer.seconds() * 1e9 / zones);
+
+    const int games = 2000;
+    ticksPerSecond(games / 4); // прогрев
+    double off = ticksPerSecond(games);
+    Profiler::setEnabled(true);
+    double on = ticksPerSecond(games);
+    Profiler::setEnabled(false);
+
+    std::printf("%-18s %14s %10s\n", "profiler", "ticks/s", "overhead");
+    std::printf("%-18s %14.0f %9.1f%%\n", "disabled", off, 0.0);
+    std::printf("%-18s %14.0f %9.1f%%\n", "enabled", on, (off / on - 1.0) * 100.0);
+
+    std::printf("\n");
+    Profiler::printSummary(stdout);
+    if (!Profiler::writeChromeTrace(tracePath)) {
+        std::fprintf(stderr, "cannot write %s\n", tracePath);
+        return 1;
+    }
+    std::printf("trace: %s\n", tracePath);
+    return 0;
+}
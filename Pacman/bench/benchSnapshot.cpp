@@ -0,0 +1,98 @@
+// Скорость снимков: snapshot()/restore() против копирования Game целиком,
+// плюс проверка, что откат к снимку воспроизводит партию тик в тик
+#include "simulation.h"
+#include "benchUtil.h"
+#include <cstdio>
+#include <cstring>
+
+// Снимки сравниваются побайтно, поэтому заполнение между полями обнуляется
+static void takeSnapshot(const Game& game, GameState& state) {
+    std::memset(&state, 0, sizeof(state));
+    game.snapshot(state);
+}
+
+static void play(Game& game, uint64_t botSeed, int ticks) {
+    RandomBot bot(botSeed);
+    for (int t = 0; t < ticks && !game.isGameOver(); t++) {
+        applyAction(game, bot.act(game));
+        game.update();
+    }
+}
+
+int main() {
+    Game game(SIM_MAP_WIDTH, SIM_MAP_HEIGHT, 7);
+    game.startGame();
+    play(game, 7, 300);
+
+    GameState start;
+    takeSnapshot(game, start);
+    std::printf("sizeof(GameState): %zu bytes\n", sizeof(GameState));
+
+    // Продолжение партии после restore() должно совпасть с продолжением
+    // её полной копии, сделанной в момент снимка
+    const Game original(game);
+    const int checks = 50;
+    int mismatches = 0;
+    for (int i = 0; i < checks; i++) {
+        GameState expected, restored;
+        Game copy(original);
+        play(copy, 100 + i, 400);
+        takeSnapshot(copy, expected);
+
+        play(game, 200 + i, 100); // уводим игру в сторону
+        game.restore(start);
+        play(game, 100 + i, 400);
+        takeSnapshot(game, restored);
+        if (std::memcmp(&expected, &restored, sizeof(GameState)) != 0) mismatches++;
+    }
+    std::printf("restore replays: %d/%d identical\n", checks - mismatches, checks);
+
+    const int iterations = 2000000;
+    GameState scratch;
+    Stopwatch timer;
+    for (int i = 0; i < iterations; i++) {
+        game.snapshot(scratch);
+        doNotOptimize(scratch.score);
+    }
+    double snapshotRate = iterations / timer.seconds();
+
+    timer.restart();
+    for (int i = 0; i < iterations; i++) {
+        game.restore(start);
+        doNotOptimize(game.getScore());
+    }
+    double restoreRate = iterations / timer.seconds();
+
+    timer.restart();
+    for (int i = 0; i < iterations; i++) {
+        scratch = start;
+        doNotOptimize(scratch.score);
+    }
+    double copyRate = iterations / timer.seconds();
+
+    const int gameCopies = iterations / 10;
+    timer.restart();
+    for (int i = 0; i < gameCopies; i++) {
+        Game copy(game);
+        doNotOptimize(copy.getScore());
+    }
+    double gameCopyRate = gameCopies / timer.seconds();
+
+    std::printf("%-22s %14s\n", "operation", "per second");
+    std::printf("%-22s %14.0f\n", "Game copy", gameCopyRate);
+    std::printf("%-22s %14.0f\n", "snapshot()", snapshotRate);
+    std::printf("%-22s %14.0f\n", "restore()", restoreRate);
+    std::printf("%-22s %14.0f\n", "GameState copy", copyRate);
+
+    // Типичный откат поиска: restore() и короткая партия
+    const int rollouts = 20000;
+    const int rolloutTicks = 60;
+    timer.restart();
+    for (int i = 0; i < rollouts; i++) {
+        game.restore(start);
+        play(game, i, rolloutTicks);
+    }
+    std::printf("rollouts (%d ticks):   %.0f/s\n", rolloutTicks, rollouts / timer.seconds());
+
+    return mismatches == 0 ? 0 : 1;
+}
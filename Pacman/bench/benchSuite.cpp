@@ -0,0 +1,467 @@
+// Набор бенчмарков с постоянными именами и выводом в JSON, чтобы
+// сравнивать прогоны между коммитами. Симуляция по фазам игры, призраки по
+// режимам, запросы к карте, построение карты, загрузка моделей, буфер
+// экземпляров пеллетов, сборка меша стен и сортировка очереди отрисовки.
+//
+//   bench_suite [--out FILE] [--reps N] [--filter TEXT] [--list]
+#include "simulation.h"
+#include "pelletInstances.h"
+#include "wallMesh.h"
+#include "renderQueue.h"
+#include "random.h"
+#include "benchUtil.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#ifdef PACMAN_BENCH_MODELS
+#include "model3DS.h"
+#endif
+
+struct CaseResult {
+    std::string name;
+    std::string skipped; // причина, если случай не запускался
+    long long ops;       // операций за повтор
+    int reps;
+    double median, min, max; // нс на операцию
+};
+
+class BenchSuite {
+private:
+    std::vector<CaseResult> results;
+    int reps;
+    const char* filter;
+    bool listOnly;
+
+    bool selected(const char* name) const {
+        return !filter || std::strstr(name, filter) != nullptr;
+    }
+
+    // timed(batches) возвращает время в секундах, за которое прошли batches
+    // батчей
+    template <typename Timed>
+    void measure(const char* name, long long opsPerBatch, Timed timed) {
+        if (!selected(name)) return;
+        if (listOnly) {
+            std::printf("%s\n", name);
+            return;
+        }
+
+        long long batches = 1;
+        for (;;) {
+            if (timed(batches) >= 0.005 || batches >= (1LL << 30)) break;
+            batches *= 2;
+        }
+
+        std::vector<double> times;
+        for (int r = 0; r < reps; r++) {
+            times.push_back(timed(batches) * 1e9 / (batches * opsPerBatch));
+        }
+        std::sort(times.begin(), times.end());
+
+        CaseResult result;
+        result.name = name;
+        result.ops = batches * opsPerBatch;
+        result.reps = reps;
+        result.median = times[times.size() / 2];
+        result.min = times.front();
+        result.max = times.back();
+        results.push_back(result);
+        std::fprintf(stderr, "%-32s %12.2f ns/op\n", name, result.median);
+    }
+
+public:
+    BenchSuite(int reps, const char* filter, bool listOnly)
+        : reps(reps), filter(filter), listOnly(listOnly) {}
+
+    // fn(batches) выполняет batches * opsPerBatch операций. Число батчей
+    // подбирается так, чтобы повтор шёл не меньше 5 мс; результат - медиана
+    // по повторам.
+    template <typename Fn>
+    void run(const char* name, long long opsPerBatch, Fn fn) {
+        measure(name, opsPerBatch, [&fn](long long batches) {
+            Stopwatch timer;
+            fn(batches);
+            return timer.seconds();
+        });
+    }
+
+    // Как run, но перед каждым батчем вызывается setup(), и его время в
+    // результат не входит: fn() - один батч из opsPerBatch операций над
+    // тем, что приготовил setup. Батч должен быть заметно длиннее чтения
+    // часов (микросекунды и больше).
+    template <typename Setup, typename Fn>
+    void runPrepared(const char* name, long long opsPerBatch, Setup setup, Fn fn) {
+        measure(name, opsPerBatch, [&setup, &fn](long long batches) {
+            double seconds = 0.0;
+            for (long long b = 0; b < batches; b++) {
+                setup();
+                Stopwatch timer;
+                fn();
+                seconds += timer.seconds();
+            }
+            return seconds;
+        });
+    }
+
+    // Случай, который в этой сборке не измерить; имя остаётся в отчёте
+    void skip(const char* name, const char* reason) {
+        if (!selected(name)) return;
+        if (listOnly) {
+            std::printf("%s\n", name);
+            return;
+        }
+        CaseResult result;
+        result.name = name;
+        result.skipped = reason;
+        result.ops = 0;
+        result.reps = 0;
+        result.median = result.min = result.max = 0.0;
+        results.push_back(result);
+        std::fprintf(stderr, "%-32s skipped: %s\n", name, reason);
+    }
+
+    void writeJson(FILE* out) const {
+        std::fprintf(out, "{\n  \"suite\": \"pacman\",\n  \"version\": 1,\n  \"unit\": \"ns/op\",\n  \"cases\": [\n");
+        for (size_t i = 0; i < results.size(); i++) {
+            const CaseResult& r = results[i];
+            if (!r.skipped.empty()) {
+                std::fprintf(out, "    {\"name\": \"%s\", \"skipped\": \"%s\"}", r.name.c_str(), r.skipped.c_str());
+            }
+            else {
+                std::fprintf(out, "    {\"name\": \"%s\", \"ops\": %lld, \"reps\": %d, "
+                    "\"median\": %.3f, \"min\": %.3f, \"max\": %.3f}",
+                    r.name.c_str(), r.ops, r.reps, r.median, r.min, r.max);
+            }
+            std::fprintf(out, "%s\n", i + 1 < results.size() ? "," : "");
+        }
+        std::fprintf(out, "  ]\n}\n");
+    }
+};
+
+const int PHASE_TICKS = 256;
+
+// Фаза партии для Game::update: снимок и ввод бота на PHASE_TICKS тиков
+// вперёд. Случайный бот погибает за тысячу тиков, поэтому поздние фазы не
+// доигрываются, а собираются: прогрев ботом, затем на карте оставляется
+// coinsLeft монет (каждая n-я) и при power включается режим силы.
+struct Phase {
+    GameState state;
+    std::vector<Action> actions;
+};
+
+static Phase makePhase(int warmupTicks, int coinsLeft, bool power) {
+    Phase phase;
+    for (uint32_t seed = 1;; seed++) {
+        Game game(SIM_MAP_WIDTH, SIM_MAP_HEIGHT, seed);
+        RandomBot bot(seed);
+        game.startGame();
+        for (int t = 0; t < warmupTicks && !game.isGameOver(); t++) {
+            applyAction(game, bot.act(game));
+            game.update();
+        }
+        if (game.isGameOver()) continue;
+
+        if (power) game.activatePowerMode();
+        game.snapshot(phase.state);
+
+        if (coinsLeft >= 0) {
+            GameMap map(SIM_MAP_WIDTH, SIM_MAP_HEIGHT);
+            int total = map.getCoins().getCount();
+            int keepEvery = std::max(1, total / std::max(1, coinsLeft));
+            int index = 0;
+            std::vector<std::pair<int, int>> collected;
+            map.forEachCoin([&](int x, int y) {
+                if (index++ % keepEvery != 0) collected.push_back({ x, y });
+            });
+            for (const auto& cell : collected) map.collectCoin(cell.first, cell.second);
+            map.saveState(phase.state.map);
+            game.restore(phase.state);
+        }
+
+        // Ввод записываем заранее, чтобы бот не попал в замер
+        for (int t = 0; t < PHASE_TICKS; t++) {
+            phase.actions.push_back(bot.act(game));
+            applyAction(game, phase.actions.back());
+            game.update();
+        }
+        return phase;
+    }
+}
+
+static void benchGamePhase(BenchSuite& suite, const char* name, const Phase& phase) {
+    Game game(SIM_MAP_WIDTH, SIM_MAP_HEIGHT, 1);
+    suite.run(name, PHASE_TICKS, [&](long long batches) {
+        for (long long b = 0; b < batches; b++) {
+            game.restore(phase.state);
+            for (int t = 0; t < PHASE_TICKS; t++) {
+                applyAction(game, phase.actions[t]);
+                game.update();
+            }
+        }
+        doNotOptimize(game.getTick());
+    });
+}
+
+// Призраки из середины партии в заданном режиме; таймеры такие, что режим
+// не сменится за время замера
+enum GhostBenchMode { MODE_SCATTER, MODE_CHASE, MODE_FRIGHTENED };
+
+static void benchGhostMode(BenchSuite& suite, const char* name, const Phase& phase, GhostBenchMode mode) {
+    const int steps = 256;
+    Game game(SIM_MAP_WIDTH, SIM_MAP_HEIGHT, 1);
+    game.restore(phase.state);
+    const GameMap& map = game.getMap();
+    const Pacman& pacman = game.getPacman();
+
+    std::vector<GhostState> states(phase.state.ghosts, phase.state.ghosts + phase.state.ghostCount);
+    for (GhostState& state : states) {
+        state.inScatterMode = mode == MODE_SCATTER;
+        state.modeTimer = 1 << 30;
+        state.modeJustChanged = 0;
+        state.vulnerable = mode == MODE_FRIGHTENED;
+        state.frightenedTimer = mode == MODE_FRIGHTENED ? 1 << 30 : 0;
+    }
+    GhostTable ghosts;
+    ghosts.assign(states.size());
+
+    suite.run(name, steps * static_cast<long long>(states.size()), [&](long long batches) {
+        for (long long b = 0; b < batches; b++) {
+            Random rng(7);
+            for (size_t g = 0; g < ghosts.size(); g++) ghosts.loadState(g, states[g]);
+            for (int s = 0; s < steps; s++) {
+                for (size_t g = 0; g < ghosts.size(); g++) ghosts.update(g, map, pacman, rng);
+            }
+        }
+        doNotOptimize(ghosts.getFixedX(0));
+    });
+}
+
+struct TileQuery {
+    int x, y, toX, toY, dx, dy;
+};
+
+static void benchMapQueries(BenchSuite& suite) {
+    const int count = 4096;
+    GameMap map(SIM_MAP_WIDTH, SIM_MAP_HEIGHT);
+    map.buildDistanceTable(1);
+    GridView grid = map.getGrid();
+
+    // Клетки с запасом за край карты, как у целей призраков
+    std::vector<TileQuery> queries;
+    std::vector<TileQuery> walkable; // для mazeDistance - только проходимые пары
+    uint32_t rng = 42;
+    static const int headings[4][2] = { {0, -1}, {-1, 0}, {0, 1}, {1, 0} };
+    while (queries.size() < static_cast<size_t>(count) || walkable.size() < static_cast<size_t>(count)) {
+        TileQuery q;
+        q.x = static_cast<int>(benchRandom(rng) % (SIM_MAP_WIDTH + 2)) - 1;
+        q.y = static_cast<int>(benchRandom(rng) % (SIM_MAP_HEIGHT + 2)) - 1;
+        q.toX = static_cast<int>(benchRandom(rng) % SIM_MAP_WIDTH);
+        q.toY = static_cast<int>(benchRandom(rng) % SIM_MAP_HEIGHT);
+        const int* heading = headings[benchRandom(rng) % 4];
+        q.dx = heading[0];
+        q.dy = heading[1];
+        if (queries.size() < static_cast<size_t>(count)) queries.push_back(q);
+        if (walkable.size() < static_cast<size_t>(count) && map.canEnter(q.x, q.y) && map.canEnter(q.toX, q.toY)) {
+            walkable.push_back(q);
+        }
+    }
+
+    suite.run("map.can_enter", count, [&](long long batches) {
+        int sum = 0;
+        for (long long b = 0; b < batches; b++)
+            for (const TileQuery& q : queries) sum += map.canEnter(q.x, q.y);
+        doNotOptimize(sum);
+    });
+    suite.run("map.can_step", count, [&](long long batches) {
+        int sum = 0;
+        for (long long b = 0; b < batches; b++)
+            for (const TileQuery& q : walkable) sum += map.canStep(q.x, q.y, q.dx, q.dy);
+        doNotOptimize(sum);
+    });
+    suite.run("map.exit_mask", count, [&](long long batches) {
+        int sum = 0;
+        for (long long b = 0; b < batches; b++)
+            for (const TileQuery& q : walkable) sum += map.exitMask(q.x, q.y);
+        doNotOptimize(sum);
+    });
+    suite.run("map.grid_at", count, [&](long long batches) {
+        int sum = 0;
+        for (long long b = 0; b < batches; b++)
+            for (const TileQuery& q : queries) sum += grid.at(q.x, q.y);
+        doNotOptimize(sum);
+    });
+    suite.run("map.has_coin", count, [&](long long batches) {
+        int sum = 0;
+        for (long long b = 0; b < batches; b++)
+            for (const TileQuery& q : walkable) sum += map.hasCoin(q.x, q.y);
+        doNotOptimize(sum);
+    });
+    suite.run("map.maze_distance", count, [&](long long batches) {
+        int sum = 0;
+        for (long long b = 0; b < batches; b++)
+            for (const TileQuery& q : walkable) sum += map.mazeDistance(q.x, q.y, q.toX, q.toY);
+        doNotOptimize(sum);
+    });
+}
+
+static void benchMapBuild(BenchSuite& suite) {
+    GameMap map(SIM_MAP_WIDTH, SIM_MAP_HEIGHT);
+    suite.run("map.initialize_classic", 1, [&](long long batches) {
+        for (long long b = 0; b < batches; b++) map.initializeClassicMap();
+        doNotOptimize(map.countRemainingCoins());
+    });
+    suite.run("map.construct", 1, [&](long long batches) {
+        for (long long b = 0; b < batches; b++) {
+            GameMap built(SIM_MAP_WIDTH, SIM_MAP_HEIGHT);
+            doNotOptimize(built.countRemainingCoins());
+        }
+    });
+}
+
+static void benchModels(BenchSuite& suite) {
+#ifdef PACMAN_BENCH_MODELS
+    suite.run("model.load.pacman", 1, [](long long batches) {
+        for (long long b = 0; b < batches; b++) {
+            SimpleModel3DS model;
+            doNotOptimize(model.loadFromFile(PACMAN_ASSET_DIR "/pacman.3ds"));
+        }
+    });
+    suite.run("model.load.ghost", 1, [](long long batches) {
+        for (long long b = 0; b < batches; b++) {
+            SimpleModel3DS model;
+            doNotOptimize(model.loadFromFile(PACMAN_ASSET_DIR "/ghost.3ds"));
+        }
+    });
+#else
+    suite.skip("model.load.pacman", "built without GLUT/Assimp");
+    suite.skip("model.load.ghost", "built without GLUT/Assimp");
+#endif
+}
+
+// Буфер экземпляров монет на CPU: полная сборка (рестарт, уровень,
+// перемотка) и уборка съеденных по событиям. Загрузку в видеокарту здесь
+// не измерить - нужен контекст.
+static void benchPellets(BenchSuite& suite, const Phase& phase) {
+    const PelletLayout layout = { 2.0f, { 0.5f, 0.8f } };
+    Game game(SIM_MAP_WIDTH, SIM_MAP_HEIGHT, 1);
+    game.restore(phase.state);
+    const GameMap& map = game.getMap();
+    PelletInstances instances(layout);
+    suite.run("render.pellets.rebuild", 1, [&](long long batches) {
+        for (long long b = 0; b < batches; b++) instances.rebuild(map);
+        doNotOptimize(instances.count(PELLET_COIN));
+    });
+
+    // Все монеты карты по событиям в порядке обхода; операция - одна монета
+    std::vector<GameEvent> eaten;
+    map.forEachCoin([&eaten](int x, int y) {
+        GameEvent event = {};
+        event.type = EVENT_COIN_EATEN;
+        event.x = static_cast<int16_t>(x);
+        event.y = static_cast<int16_t>(y);
+        eaten.push_back(event);
+    });
+    // Полная сборка перед каждым батчем в замер не входит
+    suite.runPrepared("render.pellets.remove", static_cast<long long>(eaten.size()),
+        [&]() { instances.rebuild(map); },
+        [&]() {
+            for (const GameEvent& event : eaten) {
+                instances.onGameEvent(event);
+                instances.clearDirty(PELLET_COIN);
+            }
+            doNotOptimize(instances.count(PELLET_COIN));
+        });
+}
+
+// Сборка запечённого меша стен - то, что делают рестарт и смена уровня
+static void benchWallMesh(BenchSuite& suite) {
+    const WallShape shape = { 2.0f, 1.8f, 0.0f, 2.0f };
+    GameMap map(SIM_MAP_WIDTH, SIM_MAP_HEIGHT);
+    WallMeshBuilder builder;
+    MeshData mesh;
+    suite.run("render.wall_mesh.build", 1, [&](long long batches) {
+        for (long long b = 0; b < batches; b++) doNotOptimize(builder.build(map, shape, mesh).quads);
+    });
+}
+
+// Сортировка очереди отрисовки: кадр сцены (около 20 элементов) и 1024
+// элемента - запас на случай, когда в очередь пойдут пеллеты по одному.
+// Ключи - как у сцены: два прохода, десяток материалов и мешей, глубина.
+static void benchRenderQueue(BenchSuite& suite, const char* name, int count) {
+    Random random(7);
+    std::vector<RenderItem> items(count);
+    for (int i = 0; i < count; i++) {
+        items[i].key = renderKey(random.nextBelow(2), random.nextBelow(12), random.nextBelow(16), random.nextBelow(RENDER_KEY_MAX_DEPTH));
+        items[i].object = static_cast<uint32_t>(i);
+    }
+    std::vector<RenderItem> sorted;
+    std::vector<RenderItem> scratch;
+    sorted.reserve(count);
+    scratch.reserve(count);
+    suite.run(name, count, [&](long long batches) {
+        for (long long b = 0; b < batches; b++) {
+            sorted.assign(items.begin(), items.end());
+            radixSortRenderItems(sorted, scratch);
+        }
+        doNotOptimize(sorted[0].key);
+    });
+}
+
+int main(int argc, char** argv) {
+    const char* outPath = nullptr;
+    const char* filter = nullptr;
+    int reps = 15;
+    bool listOnly = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) outPath = argv[++i];
+        else if (std::strcmp(argv[i], "--reps") == 0 && i + 1 < argc) reps = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) filter = argv[++i];
+        else if (std::strcmp(argv[i], "--list") == 0) listOnly = true;
+        else {
+            std::fprintf(stderr, "usage: bench_suite [--out FILE] [--reps N] [--filter TEXT] [--list]\n");
+            return 1;
+        }
+    }
+
+    BenchSuite suite(reps, filter, listOnly);
+
+    Phase start = makePhase(0, -1, false);
+    Phase midgame = makePhase(240, 120, false);
+    Phase power = makePhase(240, 120, true);
+    Phase endgame = makePhase(240, 12, false);
+
+    benchGamePhase(suite, "game.update.start", start);
+    benchGamePhase(suite, "game.update.midgame", midgame);
+    benchGamePhase(suite, "game.update.power", power);
+    benchGamePhase(suite, "game.update.endgame", endgame);
+
+    benchGhostMode(suite, "ghost.update.scatter", midgame, MODE_SCATTER);
+    benchGhostMode(suite, "ghost.update.chase", midgame, MODE_CHASE);
+    benchGhostMode(suite, "ghost.update.frightened", midgame, MODE_FRIGHTENED);
+
+    benchMapQueries(suite);
+    benchMapBuild(suite);
+    benchModels(suite);
+
+    benchPellets(suite, start);
+    benchWallMesh(suite);
+    benchRenderQueue(suite, "render.queue.sort.scene", 20);
+    benchRenderQueue(suite, "render.queue.sort.1024", 1024);
+
+    if (listOnly) return 0;
+
+    FILE* out = outPath ? std::fopen(outPath, "w") : stdout;
+    if (!out) {
+        std::fprintf(stderr, "cannot write %s\n", outPath);
+        return 1;
+    }
+    suite.writeJson(out);
+    if (outPath && std::fclose(out) != 0) {
+        std::fprintf(stderr, "cannot write %s\n", outPath);
+        return 1;
+    }
+    return 0;
+}
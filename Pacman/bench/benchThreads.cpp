@@ -0,0 +1,54 @@
+// Масштабирование ParallelRunner по числу потоков (1..N)
+#include "simulation.h"
+#include "benchUtil.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+static bool sameResults(const std::vector<GameResult>& a, const std::vector<GameResult>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].score != b[i].score || a[i].level != b[i].level ||
+            a[i].ticks != b[i].ticks || a[i].gameOver != b[i].gameOver ||
+            a[i].stateHash != b[i].stateHash) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int maxThreads = static_cast<int>(std::thread::hardware_concurrency());
+    int games = 2000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--threads") == 0) maxThreads = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--games") == 0) games = std::atoi(argv[i + 1]);
+    }
+    if (maxThreads <= 0) maxThreads = 1;
+
+    const int maxTicks = 20000;
+    std::vector<GameResult> reference;
+    double baseRate = 0.0;
+
+    std::printf("%8s %12s %14s %10s %10s\n", "threads", "games/s", "ticks/s", "speedup", "identical");
+    for (int threads = 1; threads <= maxThreads; threads++) {
+        ParallelRunner runner(threads);
+        Stopwatch timer;
+        std::vector<GameResult> results = runGames(runner, 1, games, maxTicks);
+        double seconds = timer.seconds();
+
+        long long ticks = 0;
+        for (const GameResult& result : results) ticks += result.ticks;
+
+        double rate = games / seconds;
+        if (threads == 1) {
+            reference = results;
+            baseRate = rate;
+        }
+        std::printf("%8d %12.1f %14.0f %9.2fx %10s\n", threads, rate, ticks / seconds,
+            rate / baseRate, sameResults(reference, results) ? "yes" : "NO");
+    }
+    return 0;
+}
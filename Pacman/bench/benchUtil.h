@@ -0,0 +1,45 @@
+#ifndef BENCHUTIL_H
+#define BENCHUTIL_H
+
+#include <chrono>
+#include <cstdint>
+
+// Общие мелочи для бенчмарков
+class Stopwatch {
+private:
+    std::chrono::steady_clock::time_point start;
+
+public:
+    Stopwatch() : start(std::chrono::steady_clock::now()) {}
+
+    void restart() { start = std::chrono::steady_clock::now(); }
+
+    double seconds() const {
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return s > 0.0 ? s : 1e-9;
+    }
+};
+
+// Не даём компилятору выбросить результат измеряемого кода. В GCC/Clang -
+// пустая ассемблерная вставка, которая "читает" значение; в MSVC её нет,
+// поэтому значение читается через volatile-указатель (без общей переменной,
+// так что потоки бенчмарка друг другу не мешают).
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    const volatile char* bytes = reinterpret_cast<const volatile char*>(&value);
+    (void)*bytes;
+#endif
+}
+
+// Быстрый детерминированный генератор для входных данных бенчмарков
+inline uint32_t benchRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+#endif